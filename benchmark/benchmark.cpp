@@ -0,0 +1,321 @@
+#ifdef DOM_BENCHMARK
+
+/*
+	Hot path microbenchmarks. Self-contained: synthetic servers are generated and compiled at startup, nothing is read from fixed paths.
+	Build with DOM_BENCHMARK defined and DOM_BENCH_ROOT naming the repository, which the generated server includes, e.g.
+	`c++ -std=c++17 -O2 -DDOM_BENCHMARK -DDOM_BENCH_ROOT="\"$PWD\"" -I. benchmark/benchmark.cpp -ldl -pthread -o dom-benchmark`;
+	without it the source must be compiled by its absolute path
+	Results go to stdout as JSON lines, one measurement per line; diagnostics go to stderr.
+
+	dom-benchmark [--classes N] [--interfaces M] [--threads T] [--registry C1,C2,..] [--millis MS] [--filter NAME]
+	The remote benchmarks start this executable again as the host of the generated server.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/dom/dom.h"
+
+/* First interface of the generated server, declared alike and marshaled for the remote benchmarks */
+struct IBench0 : public virtual Dom::IUnknown { virtual long Call0() = 0; IID(Bench0) };
+DOM_REMOTE_INTERFACE(IBench0, &IBench0::Call0)
+class Bench0Proxy : public Dom::Remote::Proxy<Bench0Proxy, IBench0> {
+public:
+	using Proxy::Proxy;
+	virtual long Call0() { return Invoke<IBench0, 0, long>(); }
+};
+DOM_REMOTE_PROXY(Bench0Proxy)
+
+namespace {
+
+	/* One class per reference counting policy */
+	struct StrictBench : public Dom::Client::Embedded<StrictBench, IBench0> { virtual long Call0() { return 0; } CLSID(StrictBench) };
+	struct RelaxedBench : public Dom::Client::Embedded<RelaxedBench, IBench0> { using refcount_policy = Dom::RefCount::Relaxed; virtual long Call0() { return 0; } CLSID(RelaxedBench) };
+	struct SingleBench : public Dom::Client::Embedded<SingleBench, IBench0> { using refcount_policy = Dom::RefCount::Single; virtual long Call0() { return 0; } CLSID(SingleBench) };
+
+	struct Options {
+		size_t				Classes = 16;
+		size_t				Interfaces = 8;
+		size_t				Threads = 64;
+		std::vector<size_t>	Registry = { 10, 1000, 100000 };
+		size_t				Millis = 200;
+		std::string			Filter;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	static inline double Nanos(Clock::time_point start, Clock::time_point end = Clock::now()) { return std::chrono::duration<double, std::nano>(end - start).count(); }
+
+	/* One JSON object per line: {"bench":..., parameters..., "value":..., "unit":...} */
+	static inline void Report(const char* bench, const std::string& params, double value, const char* unit) {
+		printf("{\"bench\":\"%s\"%s%s,\"value\":%.3f,\"unit\":\"%s\"}\n", bench, params.empty() ? "" : ",", params.c_str(), value, unit);
+		fflush(stdout);
+	}
+	static inline std::string Param(const char* name, size_t value) { return std::string("\"") + name + "\":" + std::to_string(value); }
+	static inline std::string Params(std::initializer_list<std::string> list) {
+		std::string result;
+		for (auto&& p : list) { result += (result.empty() ? "" : ",") + p; }
+		return result;
+	}
+
+	/* Absolute, so the benchmark runs from any directory */
+	static inline std::string Root() {
+#ifdef DOM_BENCH_ROOT
+		return DOM_BENCH_ROOT;
+#else
+		static_assert(__FILE__[0] == '/', "benchmark.cpp compiled by a relative path: define DOM_BENCH_ROOT as the absolute path of the repository");
+		std::string file(__FILE__);
+		return file.substr(0, file.rfind("/benchmark/"));
+#endif
+	}
+
+	/* Server with `classes` classes, each implementing the same `interfaces` interfaces */
+	static inline bool Generate(const std::string& dir, size_t classes, size_t interfaces, std::string& so) {
+		auto source = dir + "/server.cpp";
+		so = dir + "/lib-bench.so";
+		{
+			std::ofstream out(source);
+			out << "#include \"src/dom/dom.h\"\n";
+			for (size_t i = 0; i < interfaces; i++) {
+				out << "struct IBench" << i << " : public virtual Dom::IUnknown { virtual long Call" << i << "() = 0; IID(Bench" << i << ") };\n";
+			}
+			for (size_t c = 0; c < classes; c++) {
+				out << "class Bench" << c << " : public Dom::Server::Object<Bench" << c;
+				for (size_t i = 0; i < interfaces; i++) out << ", IBench" << i;
+				out << "> {\npublic:\n";
+				for (size_t i = 0; i < interfaces; i++) out << "\tvirtual long Call" << i << "() { return " << i << "; }\n";
+				out << "\tCLSID(Bench" << c << ")\n};\n";
+			}
+			out << "DOM_SERVER_EXPORT(Dom::Server::ClassRegistry";
+			for (size_t c = 0; c < classes; c++) out << ", Bench" << c;
+			out << ");\n";
+			if (!out) return false;
+		}
+		auto cxx = getenv("CXX");
+		auto cmd = std::string(cxx != nullptr ? cxx : "c++") + " -std=c++17 -O2 -fPIC -shared -I'" + Root() + "' -o '" + so + "' '" + source + "'";
+		fprintf(stderr, "%s\n", cmd.c_str());
+		return system(cmd.c_str()) == 0;
+	}
+
+	/* Registry tree of `classes` links to `so`, spread over 100 scopes */
+	static inline bool Populate(const std::string& registry, const std::string& so, size_t classes) {
+		if (mkdir(registry.c_str(), 0755) != 0) return false;
+		for (size_t s = 0; s < std::min<size_t>(classes, 100); s++) {
+			if (mkdir((registry + "/scope-" + std::to_string(s)).c_str(), 0755) != 0) return false;
+		}
+		for (size_t c = 0; c < classes; c++) {
+			auto link = registry + "/scope-" + std::to_string(c % 100) + "/Bench" + std::to_string(c);
+			if (symlink(so.c_str(), link.c_str()) != 0) return false;
+		}
+		return true;
+	}
+
+	static inline void QueryInterface(const Options& opt, const std::string& so) {
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(so);
+		Dom::IUnknown* unkn;
+		if (!manager.CreateInstance("Bench0", (void**)&unkn)) { fprintf(stderr, "CreateInstance(Bench0) failed\n"); return; }
+
+		const size_t Ops = 10000000;
+		auto params = Params({ Param("interfaces", opt.Interfaces) });
+		for (auto hit : { true, false }) {
+			Dom::uiid iid = Dom::IId(hit ? "Bench" + std::to_string(opt.Interfaces - 1) : std::string("BenchMissing"));
+			void* ppv;
+			auto start = Clock::now();
+			for (size_t n = 0; n < Ops; n++) { unkn->QueryInterface(iid, &ppv); }
+			Report(hit ? "qi.hit" : "qi.miss", params, Nanos(start) / Ops, "ns/op");
+		}
+		{
+			auto start = Clock::now();
+			for (size_t n = 0; n < Ops; n++) { unkn->AddRef(); unkn->Release(); }
+			Report("refcount.addref_release", "", Nanos(start) / Ops, "ns/op");
+		}
+		unkn->Release();
+	}
+
+	/* AddRef/Release pair on an in-process object under each reference counting policy */
+	static inline void RefCount() {
+		const size_t Ops = 10000000;
+		auto measure = [&](const char* bench, Dom::IUnknown* unkn) {
+			unkn->AddRef();
+			auto start = Clock::now();
+			for (size_t n = 0; n < Ops; n++) { unkn->AddRef(); unkn->Release(); }
+			Report(bench, "", Nanos(start) / Ops, "ns/op");
+			unkn->Release();
+		};
+		measure("refcount.strict", *new StrictBench);
+		measure("refcount.relaxed", *new RelaxedBench);
+		measure("refcount.single", *new SingleBench);
+	}
+
+	static inline void CreateInstance(const Options& opt, const std::string& so) {
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(so);
+		for (size_t threads = 1; threads <= opt.Threads; threads *= 2) {
+			std::atomic_bool go(false), stop(false);
+			std::atomic_size_t total(0);
+			std::vector<std::thread> workers;
+			for (size_t n = 0; n < threads; n++) {
+				workers.emplace_back([&]() {
+					size_t count = 0;
+					Dom::IUnknown* unkn;
+					while (!go.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+					while (!stop.load(std::memory_order_relaxed)) {
+						if (manager.CreateInstance("Bench0", (void**)&unkn)) unkn->Release();
+						count++;
+					}
+					total += count;
+				});
+			}
+			auto start = Clock::now();
+			go = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(opt.Millis));
+			stop = true;
+			for (auto&& worker : workers) worker.join();
+			Report("manager.create_instance", Params({ Param("threads", threads) }), total * 1e9 / Nanos(start), "ops/s");
+		}
+	}
+
+	static inline void LoadRegistry(const Options& opt, const std::string& dir, const std::string& so) {
+		for (auto classes : opt.Registry) {
+			auto registry = dir + "/registry-" + std::to_string(classes);
+			if (!Populate(registry, so, classes)) { fprintf(stderr, "Registry `%s` not created `%s`\n", registry.c_str(), strerror(errno)); return; }
+			auto params = Params({ Param("classes", classes) });
+
+			/* First load builds the index, later ones map it */
+			for (auto&& run : { std::make_pair("registry.load_cold", Dom::Client::LoadMode::Lazy), std::make_pair("registry.load_lazy", Dom::Client::LoadMode::Lazy), std::make_pair("registry.load_eager", Dom::Client::LoadMode::Eager) }) {
+				auto start = Clock::now();
+				{
+					Dom::Client::Manager<> manager;
+					manager.LoadRegistry(registry, run.second);
+				}
+				Report(run.first, params, Nanos(start) / 1e6, "ms");
+			}
+		}
+	}
+
+	static inline void EmplaceServer(const Options& opt, const std::string& so) {
+		const size_t Runs = 200;
+		auto start = Clock::now();
+		for (size_t n = 0; n < Runs; n++) {
+			Dom::Client::Manager<> manager;
+			manager.EmplaceServer(so);
+		}
+		Report("manager.emplace_server", Params({ Param("classes", opt.Classes) }), Nanos(start) / Runs / 1e3, "us/op");
+	}
+
+	/* The same call and batch creation on in-process objects and on proxies of a host process, then remote calls from
+	   concurrent threads, which share the host's request queue */
+	static inline void Remote(const Options& opt, const std::string& so) {
+		const size_t Calls = 100000, Objects = 1000;
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(so, "inproc");
+		manager.EmplaceRemoteServer(so, "remote");
+		for (auto scope : { "inproc", "remote" }) {
+			Dom::Interface<IBench0> bench;
+			if (!manager.CreateInstance("Bench0", bench, scope)) { fprintf(stderr, "CreateInstance(%s/Bench0) failed\n", scope); return; }
+			volatile long sink = 0;
+			auto start = Clock::now();
+			for (size_t n = 0; n < Calls; n++) { sink = sink + bench->Call0(); }
+			Report((std::string("call.") + scope).c_str(), "", Nanos(start) / Calls, "ns/op");
+
+			std::vector<Dom::IUnknown*> objects(Objects, nullptr);
+			start = Clock::now();
+			auto created = manager.CreateInstances("Bench0", Objects, (void**)objects.data(), scope);
+			for (size_t n = 0; n < created; n++) objects[n]->Release();
+			Report((std::string("create_batch.") + scope).c_str(), Params({ Param("objects", Objects) }), Nanos(start) / Objects, "ns/op");
+		}
+		for (size_t threads = 1; threads <= opt.Threads; threads *= 2) {
+			std::atomic_bool go(false), stop(false);
+			std::atomic_size_t total(0);
+			std::vector<std::thread> workers;
+			for (size_t n = 0; n < threads; n++) {
+				workers.emplace_back([&]() {
+					size_t count = 0;
+					Dom::Interface<IBench0> bench;
+					manager.CreateInstance("Bench0", bench, "remote");
+					while (!go.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+					while (bench && !stop.load(std::memory_order_relaxed)) { bench->Call0(); count++; }
+					total += count;
+				});
+			}
+			auto start = Clock::now();
+			go = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(opt.Millis));
+			stop = true;
+			for (auto&& worker : workers) worker.join();
+			Report("call.remote_threads", Params({ Param("threads", threads) }), total * 1e9 / Nanos(start), "ops/s");
+		}
+	}
+
+	/* Cost of one DOM_CALL_TRACE-like event with a string and an integer argument, tracer off and on */
+	static inline void TraceEvent() {
+		const size_t Ops = 10000000;
+		auto tracer = Dom::Trace::Tracer::Current();
+		for (auto enabled : { false, true }) {
+			tracer->Enable(enabled);
+			auto start = Clock::now();
+			for (size_t n = 0; n < Ops; n++) { DOM_TRACE_EVENT(Dom::Trace::Call, "%s (%ld)", "bench", (long)n); }
+			Report(enabled ? "trace.event_enabled" : "trace.event_disabled", "", Nanos(start) / Ops, "ns/op");
+		}
+		tracer->Enable(false);
+	}
+
+	static inline std::vector<size_t> List(char* value) {
+		std::vector<size_t> list;
+		for (char* p = value; ; p++) {
+			list.push_back(strtoul(p, &p, 10));
+			if (*p != ',') break;
+		}
+		return list;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (int rc = Dom::Remote::Serve(argc, argv); rc >= 0) return rc;
+
+	Options opt;
+	for (int n = 1; n + 1 < argc; n += 2) {
+		if (!strcmp(argv[n], "--classes")) opt.Classes = std::max<size_t>(1, strtoul(argv[n + 1], nullptr, 10));
+		else if (!strcmp(argv[n], "--interfaces")) opt.Interfaces = std::max<size_t>(1, strtoul(argv[n + 1], nullptr, 10));
+		else if (!strcmp(argv[n], "--threads")) opt.Threads = std::max<size_t>(1, strtoul(argv[n + 1], nullptr, 10));
+		else if (!strcmp(argv[n], "--registry")) opt.Registry = List(argv[n + 1]);
+		else if (!strcmp(argv[n], "--millis")) opt.Millis = strtoul(argv[n + 1], nullptr, 10);
+		else if (!strcmp(argv[n], "--filter")) opt.Filter = argv[n + 1];
+	}
+
+	char dir[] = "/tmp/dom-benchmark-XXXXXX";
+	if (mkdtemp(dir) == nullptr) { fprintf(stderr, "mkdtemp `%s`\n", strerror(errno)); return 1; }
+	std::string so;
+	if (!Generate(dir, opt.Classes, opt.Interfaces, so)) { fprintf(stderr, "Server generation failed\n"); return 1; }
+
+#ifdef DOM_QI_CACHE
+	const bool cache = true;
+#else
+	const bool cache = false;
+#endif
+	printf("{\"bench\":\"meta\",\"compiler\":\"%s\",\"qi_cache\":%s,\"cores\":%u,\"classes\":%zu,\"interfaces\":%zu}\n", __VERSION__, cache ? "true" : "false", std::thread::hardware_concurrency(), opt.Classes, opt.Interfaces);
+
+	auto Enabled = [&](const char* name) { return opt.Filter.empty() || strstr(name, opt.Filter.c_str()) != nullptr; };
+	if (Enabled("qi") || Enabled("refcount")) QueryInterface(opt, so);
+	if (Enabled("refcount")) RefCount();
+	if (Enabled("manager.create_instance")) CreateInstance(opt, so);
+	if (Enabled("registry")) LoadRegistry(opt, dir, so);
+	if (Enabled("manager.emplace_server")) EmplaceServer(opt, so);
+	if (Enabled("trace")) TraceEvent();
+	if (Enabled("call") || Enabled("create_batch")) Remote(opt, so);
+
+	system((std::string("rm -rf '") + dir + "'").c_str());
+	return 0;
+}
+
+#endif // DOM_BENCHMARK
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "../src/dom/dom.h"
+
+/* Values and a buffer across a remote proxy, see Case #16 */
+struct IChecksum : virtual public Dom::IUnknown {
+	virtual uint64_t Sum(Dom::Remote::Buffer data, uint64_t seed) = 0;
+
+	IID(Checksum)
+};
@@ -2,6 +2,7 @@
 
 #include "../src/dom/dom.h"
 #include "IHello.h"
+#include "IChecksum.h"
 
 class SimpleHello : public Dom::Server::Object<SimpleHello, IHello> {
 public:
@@ -13,6 +14,42 @@ public:
 	CLSID(SimpleHello)
 };
 
-DOM_SERVER_EXPORT(Dom::Server::ClassRegistry, SimpleHello);
+class QuietHello : public Dom::Server::Object<QuietHello, IHello> {
+public:
+	using pool_policy = Dom::Server::Pool<>;
+	virtual void Say() { ; }
+	CLSID(QuietHello)
+};
+
+class Checksum : public Dom::Server::Object<Checksum, IHello, IChecksum> {
+public:
+	virtual void Say() { ; }
+	virtual uint64_t Sum(Dom::Remote::Buffer data, uint64_t seed) { return Dom::GuidFold((const char*)data.Data, data.Size, seed); }
+	CLSID(Checksum)
+};
+
+/* Stateless services under each cached activation model, see Case #17 */
+class SharedHello : public Dom::Server::Object<SharedHello, IHello> {
+public:
+	using activation_policy = Dom::Server::Activation::Singleton;
+	virtual void Say() { ; }
+	CLSID(SharedHello)
+};
+
+class ThreadHello : public Dom::Server::Object<ThreadHello, IHello> {
+public:
+	using activation_policy = Dom::Server::Activation::PerThread;
+	virtual void Say() { ; }
+	CLSID(ThreadHello)
+};
+
+class PooledHello : public Dom::Server::Object<PooledHello, IHello> {
+public:
+	using activation_policy = Dom::Server::Activation::Pooled<4>;
+	virtual void Say() { ; }
+	CLSID(PooledHello)
+};
+
+DOM_SERVER_EXPORT(Dom::Server::ClassRegistry, SimpleHello, QuietHello, Checksum, SharedHello, ThreadHello, PooledHello);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include "IUnknown.h"
+#include <cstddef>
+
+namespace Dom {
+	/* Host memory for server objects, offered to servers through DllInitialize. `align` is a power of two;
+	   a block is freed with the size and alignment it was allocated with, possibly on another thread */
+	struct IAllocator : public virtual IUnknown {
+		virtual void* Allocate(size_t /* size */, size_t /* align */) = 0;
+		virtual void Deallocate(void* /* block */, size_t /* size */, size_t /* align */) = 0;
+
+		IID(Allocator)
+	};
+}
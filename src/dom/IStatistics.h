@@ -0,0 +1,64 @@
+#pragma once
+#include "IUnknown.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Dom {
+	/* Runtime counters of a Manager, exposed through QueryInterface only while statistics are enabled */
+	struct IStatistics : public virtual IUnknown {
+		struct Class {
+			std::string	Name;
+			std::string	Scope;
+			uint64_t	Creates;
+			uint64_t	Failures;
+			/* Instances alive in the server image, shared by every scope bound to it; -1 if the server does not report it */
+			long		Live;
+		};
+		struct Scope {
+			std::string	Name;
+			uint64_t	Creates;
+			uint64_t	Failures;
+		};
+		struct Server {
+			std::string	SoName;
+			bool		Loaded;
+			/* dlopen and symbol lookup of the last load */
+			uint64_t	LoadNanos;
+			/* Opens and idle-sweeper closes; every load after the first is a reload */
+			uint64_t	Loads;
+			uint64_t	Unloads;
+			/* Drop of the process resident set across its sweeper unloads */
+			uint64_t	ReclaimedBytes;
+		};
+		/* Bucket n counts latencies below 2^n ns (and at least 2^(n-1)); the last bucket takes everything above */
+		struct Histogram {
+			static constexpr size_t Buckets = 32;
+			uint64_t	Count[Buckets];
+			uint64_t	Total;
+			uint64_t	SumNanos;
+		};
+		/* Class table writers: lock acquisition, time under the lock, and the part of it spent waiting for readers to leave the old snapshot */
+		struct Lock {
+			uint64_t	Acquired;
+			uint64_t	WaitNanos;
+			uint64_t	MaxWaitNanos;
+			uint64_t	HoldNanos;
+			uint64_t	PublishNanos;
+		};
+		struct Snapshot {
+			std::vector<Class>	Classes;
+			std::vector<Scope>	Scopes;
+			std::vector<Server>	Servers;
+			Histogram			CreateLatency;
+			Lock				ListLock;
+			/* CreateInstance calls for a class not present in the registry */
+			uint64_t			NotFound;
+		};
+
+		/* Counters are cumulative since statistics were first enabled, scrapers take deltas */
+		virtual bool GetStatistics(Snapshot& /* out */) = 0;
+
+		IID(Statistics)
+	};
+}
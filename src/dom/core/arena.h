@@ -0,0 +1,111 @@
+#pragma once
+#include "../IAllocator.h"
+#include <new>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+namespace Dom {
+	namespace Client {
+
+		/* Bump arena for the objects of one request. Freeing a block only counts it, Reset() gives every block back at once.
+		   Filled by one thread at a time, blocks may be freed on any thread */
+		class RequestArena {
+			struct Chunk {
+				char*	data;
+				size_t	size;
+			};
+			std::vector<Chunk>		chunks;
+			size_t					chunkSize, current, used;
+			std::atomic_long		live;
+		public:
+			static constexpr size_t DefaultChunk = 64 * 1024;
+
+			RequestArena(size_t ChunkSize = DefaultChunk) : chunkSize(ChunkSize), current(0), used(0), live(0) { ; }
+			RequestArena(const RequestArena&) = delete;
+			/* Chunks with live objects are leaked rather than handed back under them */
+			~RequestArena() {
+				if (live.load() != 0) {
+					DOM_ERR("Request arena destroyed with %ld live blocks, %zu chunks leaked", live.load(), chunks.size());
+					return;
+				}
+				for (auto&& chunk : chunks) std::free(chunk.data);
+			}
+
+			inline void* Allocate(size_t size, size_t align) {
+				for (;;) {
+					if (current < chunks.size()) {
+						auto&& chunk = chunks[current];
+						auto base = (std::uintptr_t)chunk.data;
+						size_t at = ((base + used + align - 1) & ~(std::uintptr_t)(align - 1)) - base;
+						if (at + size <= chunk.size) {
+							used = at + size;
+							live.fetch_add(1, std::memory_order_relaxed);
+							return chunk.data + at;
+						}
+						if (++current < chunks.size()) { used = 0; continue; }
+					}
+					size_t size_chunk = std::max(chunkSize, size + align);
+					auto data = (char*)std::malloc(size_chunk);
+					if (data == nullptr) return nullptr;
+					chunks.push_back({ data, size_chunk });
+					current = chunks.size() - 1;
+					used = 0;
+				}
+			}
+			inline void Free() { live.fetch_sub(1, std::memory_order_release); }
+
+			/* Ends the request: all blocks are reused from the first chunk on. False, and nothing is rewound, while objects are alive */
+			inline bool Reset() {
+				if (live.load(std::memory_order_acquire) != 0) return false;
+				current = 0; used = 0;
+				return true;
+			}
+			inline long Live() const { return live.load(std::memory_order_relaxed); }
+			inline size_t Chunks() const { return chunks.size(); }
+
+			/* The arena of the calling thread's current request, nullptr outside of one */
+			static inline RequestArena*& Current() { static thread_local RequestArena* arena = nullptr; return arena; }
+
+			/* Objects created on this thread while the scope is open come from `arena`; scopes nest */
+			class Scope {
+				RequestArena*	previous;
+			public:
+				Scope(RequestArena& arena) : previous(Current()) { Current() = &arena; }
+				Scope(const Scope&) = delete;
+				~Scope() { Current() = previous; }
+			};
+		};
+
+		/* The IAllocator a Manager offers its servers: blocks come from the calling thread's RequestArena, or from the heap
+		   outside of a request. A header in front of each block remembers which, so any thread may free it */
+		class ArenaAllocator : public IAllocator {
+			static inline size_t Header(size_t align) { return std::max<size_t>(2 * sizeof(void*), align); }
+		public:
+			static inline ArenaAllocator& Instance() { static ArenaAllocator instance; return instance; }
+
+			inline virtual long AddRef() { return 1; }
+			inline virtual long Release() { return 1; }
+			inline virtual bool QueryInterface(const uiid& iid, void **ppv) {
+				if (iid == IUnknown::guid() || iid == IAllocator::guid()) { *ppv = static_cast<IAllocator*>(this); return true; }
+				return false;
+			}
+
+			inline virtual void* Allocate(size_t size, size_t align) {
+				size_t header = Header(align);
+				auto arena = RequestArena::Current();
+				char* block = arena != nullptr ? (char*)arena->Allocate(header + size, header) : (char*)::operator new(header + size, std::align_val_t(header), std::nothrow);
+				if (block == nullptr) return nullptr;
+				((RequestArena**)(block + header))[-1] = arena;
+				return block + header;
+			}
+			inline virtual void Deallocate(void* block, size_t /* size */, size_t align) {
+				size_t header = Header(align);
+				if (auto arena = ((RequestArena**)block)[-1]) arena->Free();
+				else ::operator delete((char*)block - header, std::align_val_t(header));
+			}
+		};
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "../IUnknown.h"
+#include <mutex>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+	#include <coroutine>
+	#define DOM_COROUTINES
+#endif
+
+namespace Dom {
+	namespace Client {
+
+		/* Pending CreateInstanceAsync result: wait with Get(), continue with Then() or co_await it.
+		   Continuations run on the thread that completes it, a pool worker unless the result was ready at once */
+		class AsyncInstance {
+			struct State {
+				std::mutex				lock;
+				std::condition_variable	completed;
+				bool					ready;
+				IUnknown*				object;
+				std::exception_ptr		error;
+				std::function<void()>	then;
+
+				State() : ready(false), object(nullptr) { ; }
+				/* An object nobody collected with Get() goes with the last copy of the result */
+				~State() { if (object != nullptr) object->Release(); }
+			};
+			std::shared_ptr<State>	state;
+		public:
+			AsyncInstance() : state(std::make_shared<State>()) { ; }
+			AsyncInstance(IUnknown* object, std::exception_ptr error = nullptr) : AsyncInstance() { Complete(object, error); }
+
+			inline void Complete(IUnknown* object, std::exception_ptr error = nullptr) {
+				std::function<void()> then;
+				{
+					std::unique_lock<std::mutex> sync(state->lock);
+					state->object = object;
+					state->error = error;
+					state->ready = true;
+					then.swap(state->then);
+				}
+				state->completed.notify_all();
+				if (then) then();
+			}
+
+			inline bool Ready() const { std::unique_lock<std::mutex> sync(state->lock); return state->ready; }
+			inline void Wait() const { std::unique_lock<std::mutex> sync(state->lock); state->completed.wait(sync, [this]() { return state->ready; }); }
+
+			/* Waits, then hands over the AddRef'd IUnknown exactly once: nullptr if the class was not found or not created.
+			   Rethrows what loading the server threw */
+			inline IUnknown* Get() {
+				std::unique_lock<std::mutex> sync(state->lock);
+				state->completed.wait(sync, [this]() { return state->ready; });
+				if (state->error) std::rethrow_exception(state->error);
+				IUnknown* object = state->object;
+				state->object = nullptr;
+				return object;
+			}
+
+			/* Runs `then` once completed, inline if it already is; one continuation per result */
+			inline void Then(std::function<void()>&& then) {
+				{
+					std::unique_lock<std::mutex> sync(state->lock);
+					if (!state->ready) { state->then = std::move(then); return; }
+				}
+				then();
+			}
+
+#ifdef DOM_COROUTINES
+			inline bool await_ready() const { return Ready(); }
+			inline bool await_suspend(std::coroutine_handle<> awaiting) {
+				std::unique_lock<std::mutex> sync(state->lock);
+				if (state->ready) return false;
+				state->then = [awaiting]() { awaiting.resume(); };
+				return true;
+			}
+			inline IUnknown* await_resume() { return Get(); }
+#endif // DOM_COROUTINES
+		};
+	}
+}
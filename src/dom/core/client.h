@@ -1,6 +1,20 @@
 #pragma once
 #include "../IManager.h"
 #include "../IRegistry.h"
+#include "../IStatistics.h"
+#include "interface.h"
+#include "sync.h"
+#include "statistics.h"
+#include "index.h"
+#include "watch.h"
+#include "workers.h"
+#include "async.h"
+#include "scope.h"
+#include "linked.h"
+#include "descriptor.h"
+#include "arena.h"
+#include "remote.h"
+#include <poll.h>
 #include <sys/stat.h>
 #include <dlfcn.h>
 #include <climits>
@@ -10,24 +24,28 @@
 #include <atomic>
 #include <mutex>
 #include <functional>
+#include <memory>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <system_error>
 #include <forward_list>
 
 namespace Dom {
 	namespace Client {
 
-		struct cast_interface {
-			const uiid	ciid;
-			void*		cpv;
-			template<typename TP>
-			cast_interface(const uiid iid, TP* pv) : ciid(iid), cpv(pv){ ; }
-			inline bool cast(const uiid& iid,void **ppv) const { if (ciid == iid) { *ppv = cpv; return true; }return false; }
-		};
-
 		extern "C"
 		{
 			typedef bool(*__DllCreateInstance)(const clsuid&, void**);
+			typedef size_t(*__DllCreateInstanceBatch)(const clsuid&, size_t, void**);
+			typedef long(*__DllInstanceCount)(const clsuid&);
+			typedef void(*__DllAttachTrace)(Trace::Tracer*);
 			typedef bool(*__DllCanUnloadNow)();
 			typedef bool(*__DllRegisterServer)(IUnknown*, std::string&&);
 			typedef bool(*__DllUnRegisterServer)(IUnknown*, std::string&&);
@@ -35,6 +53,7 @@ namespace Dom {
 			typedef bool(*__DllUnInstallServer)(IUnknown*);
 			typedef bool(*__DllInitialize)(IUnknown*);
 			typedef bool(*__DllFinalize)(IUnknown*);
+			typedef const ServerDescriptor*(*__DllGetServerDescriptor)();
 		}
 
 		static inline std::string PathName(const std::string&& path, const std::string&& dir = std::string()) {
@@ -44,15 +63,16 @@ namespace Dom {
 
 		static inline void EnumFiles(const std::string &path, std::function<void(const std::string&&, const struct ::dirent &)>&& cb, bool recursive = true) {
 			std::forward_list<std::string> dirs({ PathName(std::move(path)) });
+			auto tail = dirs.begin();
 			for (auto&& item : dirs) {
-				if (auto dir = opendir(path.c_str())) {
+				if (auto dir = opendir(item.c_str())) {
 					while (auto f = readdir(dir)) {
 						if (!f->d_name || f->d_name[0] == '.') continue;
 
 						if (f->d_type & DT_DIR) {
 							cb(item + f->d_name + '/', *f);
 							if (recursive) {
-								dirs.emplace_after(dirs.end(), item + f->d_name + "/");
+								tail = dirs.emplace_after(tail, item + f->d_name + "/");
 							}
 						}
 						else if (f->d_type & DT_REG) {
@@ -63,7 +83,7 @@ namespace Dom {
 				}
 #ifdef DEBUG
 				else {
-					fprintf(stderr, "Dom::FileSystem::Enum(%s) `%s (%ld)`\n", path.c_str(), strerror(errno), errno);
+					fprintf(stderr, "Dom::FileSystem::Enum(%s) `%s (%d)`\n", item.c_str(), strerror(errno), errno);
 				}
 #endif // DEBUG
 			}
@@ -75,6 +95,24 @@ namespace Dom {
 			return stat(path.c_str(), &info) == 0 ? info.st_mode : 0;
 		}
 
+		/* Resident set of the process, 0 where /proc is not available */
+		static inline uint64_t ResidentBytes()
+		{
+			unsigned long size = 0, resident = 0;
+			if (auto statm = fopen("/proc/self/statm", "r")) {
+				if (fscanf(statm, "%lu %lu", &size, &resident) != 2) resident = 0;
+				fclose(statm);
+			}
+			return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+		}
+
+		/* Links resolved to the file they name, so every registry link of a server maps to one module */
+		static inline std::string RealPath(const std::string& path)
+		{
+			char resolved[PATH_MAX];
+			return realpath(path.c_str(), resolved) != nullptr ? std::string(resolved) : path;
+		}
+
 		static inline int MakeDir(const std::string& dirname, int mode = 0777)
 		{
 			if (mkdir(dirname.c_str(), mode) == 0)
@@ -88,7 +126,7 @@ namespace Dom {
 					return 0;
 				auto res = MakeDir(dirname.substr(0, pos), mode);
 				if (!res) {
-					return mkdir(dirname.c_str(), mode);
+					return mkdir(dirname.c_str(), mode) == 0 || errno == EEXIST ? 0 : errno;
 				}
 				return res;
 			}
@@ -110,40 +148,49 @@ namespace Dom {
 #ifdef DEBUG
 				if (refs < 0) {
 					long _refs = refs;
-					fprintf(stderr, "`Object::uiid(%s)` was to be destroyed. Incorrect reference counter (%ld < 0). `%s:%ls`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
+					fprintf(stderr, "`Object::uiid(%s)` was to be destroyed. Incorrect reference counter (%ld < 0). `%s:%d`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
 				}
 #endif // DEBUG
-				DOM_CALL_TRACE("Refs<%ld>", (long)refs + 1);
-				return ++refs;
+				long n = RefCountOf<T>::type::Increment(refs);
+				DOM_CALL_TRACE("Refs<%ld>", n);
+				return n;
 			}
 			inline virtual long Release() {
-				if ((--refs) == 0) { delete static_cast<T*>(this); return 0; }
+				long n = RefCountOf<T>::type::Decrement(refs);
+				if (n == 0) { delete static_cast<T*>(this); return 0; }
 #ifdef DEBUG
-				if (refs < 0) {
-					long _refs = refs;
-					fprintf(stderr, "Incorrect release of `Object::uiid(%s)`. Reference counter less zero (%ld). `%s:%ls`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
+				if (n < 0) {
+					fprintf(stderr, "Incorrect release of `Object::uiid(%s)`. Reference counter less zero (%ld). `%s:%d`\n", T::guid().c_str(), n, __PRETTY_FUNCTION__, __LINE__);
 				}
 #endif // DEBUG
-				DOM_CALL_TRACE("Refs<%ld>", (long)refs);
-				return refs;
+				DOM_CALL_TRACE("Refs<%ld>", n);
+				return n;
 			}
 			inline virtual bool QueryInterface(const uiid& iid, void **ppv) {
-				const cast_interface guids[] = { cast_interface(IFACES::guid(),(IFACES*)this)...,cast_interface(IUnknown::guid(),(IUnknown*)this) };
-				*ppv = nullptr;
-				for (auto&& it : guids) {
-					if (it.cast(iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
-				}
-				DOM_ERR("Interface `uiid(%s)` for `uiid(%s)` not implemented", iid.c_str(), std::remove_reference<decltype(*this)>::type::guid().c_str());
+				if (InterfaceTable<Embedded, IFACES...>::Query(this, iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
+				if (iid != QueryCache::Uncached) { DOM_ERR("Interface `uiid(%s)` for `uiid(%s)` not implemented", iid.c_str(), std::remove_reference<decltype(*this)>::type::guid().c_str()); }
 				return false;
 			}
 
 		};
 
+		/* Eager opens the server on construction, Lazy on the first call that needs it */
+		enum class LoadMode { Eager, Lazy };
+
+		/* Outcome for one server of a bulk RegisterServers/EmplaceServers call, in the order the servers were given */
+		struct ServerReport {
+			std::string		SoServer;
+			bool			Succeeded;
+			std::string		Error;
+		};
+		using ServerReports = std::vector<ServerReport>;
+
 	class Dll {
 		private:
 			void*					_handle;
 			std::string				_soname;
 			__DllCreateInstance		_createinstance;
+			__DllCreateInstanceBatch	_createinstancebatch;
 			__DllCanUnloadNow		_canunloadnow;
 			__DllRegisterServer		_registerserver;
 			__DllUnRegisterServer	_unregisterserver;
@@ -151,101 +198,842 @@ namespace Dom {
 			__DllUnInstallServer	_uninstall;
 			__DllInitialize			_initialize;
 			__DllFinalize			_finalize;
+			__DllInstanceCount		_instancecount;
+			const ServerDescriptor*	_descriptor;
+			std::mutex				_lock;
+			std::atomic_bool		_loaded;
+			std::atomic<uint64_t>	_loadnanos;
+			/* Calls into the module, counted on per-thread shards so the sweeper can tell it is idle without a shared counter */
+			struct Activity {
+				std::atomic_long		Inflight;
+				std::atomic<uint64_t>	Calls;
+			};
+			Sharded<Activity>		_activity;
+			/* Resolved ClassFactory handles hold raw entry points, a pinned module is never swept */
+			std::atomic_long		_pins;
+			std::atomic<uint64_t>	_loads, _unloads, _reclaimed;
+			/* Still mapped after dlclose (STB_GNU_UNIQUE symbols make it NODELETE), not worth sweeping again */
+			bool					_resident;
+			/* Sweeper bookkeeping, touched by one sweep pass at a time. `_drained` is set by a pass that found the module closable,
+			   with the call count it saw: only a later pass that finds the same closes it */
+			uint64_t				_sweepcalls, _idlesince, _drainedcalls;
+			bool					_drained;
+			/* Handed to DllInitialize on every load, guarded by _lock */
+			IUnknown*				_host;
+
+			/* The sweeper clears _loaded before it looks at the in-flight count, a call raises the count before it looks at _loaded:
+			   with both sequentially consistent either the sweeper backs off or the call reopens the module under _lock */
+			class Call {
+				std::atomic_long&	inflight;
+			public:
+				Call(Dll& so) : inflight(so._activity.Local().Inflight) {
+					inflight.fetch_add(1);
+					so._activity.Local().Calls.fetch_add(1, std::memory_order_relaxed);
+					if (!so._loaded.load()) {
+						try { so.Load(); }
+						catch (...) { inflight.fetch_sub(1, std::memory_order_release); throw; }
+					}
+				}
+				Call(const Call&) = delete;
+				~Call() { inflight.fetch_sub(1, std::memory_order_release); }
+			};
+			/* Calls the module only if it is open, never loads it and does not count as use */
+			template<typename FN, typename R>
+			inline R IfLoaded(FN&& fn, R otherwise) {
+				auto&& inflight = _activity.Local().Inflight;
+				inflight.fetch_add(1);
+				R result = _loaded.load() ? fn() : otherwise;
+				inflight.fetch_sub(1, std::memory_order_release);
+				return result;
+			}
+			inline long Inflight() {
+				long inflight = 0;
+				_activity.ForEach([&](const Activity& local) { inflight += local.Inflight.load(); });
+				return inflight;
+			}
+			inline uint64_t Calls() {
+				uint64_t calls = 0;
+				_activity.ForEach([&](const Activity& local) { calls += local.Calls.load(std::memory_order_relaxed); });
+				return calls;
+			}
 
 			inline void __unload() {
 				if (_handle != nullptr) {
-					(*_canunloadnow)() && dlclose(_handle);
+					_loaded = false;
+					if ((_canunloadnow == nullptr || (*_canunloadnow)()) && dlclose(_handle) == 0) {
+						QueryCache::Invalidate();
+					}
 					_handle = nullptr;
-					_createinstance = nullptr;	_canunloadnow = nullptr;	_registerserver = nullptr;	_unregisterserver = nullptr;
+					_createinstance = nullptr;	_createinstancebatch = nullptr;	_canunloadnow = nullptr;	_registerserver = nullptr;	_unregisterserver = nullptr;
 					_install = nullptr;			_uninstall = nullptr;		_initialize = nullptr;		_finalize = nullptr;
+					_instancecount = nullptr;	_descriptor = nullptr;
 				}
 			}
 
 			inline void __load() {
 				if (_handle == nullptr && !_soname.empty()) {
+					auto start = Statistics::Now();
 					_handle = dlopen(_soname.c_str(), RTLD_NOW);
 					if (_handle == nullptr) {
 						throw std::system_error(EINVAL, std::system_category(), dlerror());
 					}
-					_createinstance = (__DllCreateInstance)dlsym(_handle, "DllCreateInstance");
-					_canunloadnow = (__DllCanUnloadNow)dlsym(_handle, "DllCanUnloadNow");
-					_registerserver = (__DllRegisterServer)dlsym(_handle, "DllRegisterServer");
-					_unregisterserver = (__DllUnRegisterServer)dlsym(_handle, "DllUnRegisterServer");
-					_install = (__DllInstallServer)dlsym(_handle, "DllInstallServer");
-					_uninstall = (__DllUnInstallServer)dlsym(_handle, "DllUnInstallServer");
-					_initialize = (__DllInitialize)dlsym(_handle, "DllInitialize");
-					_finalize = (__DllFinalize)dlsym(_handle, "DllFinalize");
+					/* A server that describes itself hands over every entry point in one lookup, older ones are looked up one by one */
+					__DllAttachTrace attach = nullptr;
+					if (auto describe = (__DllGetServerDescriptor)dlsym(_handle, "DllGetServerDescriptor")) {
+						_descriptor = (*describe)();
+						if (_descriptor != nullptr && _descriptor->AbiVersion != ServerDescriptor::Version) {
+							DOM_ERR("Server `%s` descriptor version %u, expected %u, ignored", _soname.c_str(), _descriptor->AbiVersion, ServerDescriptor::Version);
+							_descriptor = nullptr;
+						}
+					}
+					if (_descriptor != nullptr) {
+						_createinstance = _descriptor->CreateInstance;	_createinstancebatch = _descriptor->CreateInstanceBatch;	_canunloadnow = _descriptor->CanUnloadNow;
+						_registerserver = _descriptor->RegisterServer;	_unregisterserver = _descriptor->UnRegisterServer;		_install = _descriptor->InstallServer;
+						_uninstall = _descriptor->UnInstallServer;		_initialize = _descriptor->Initialize;					_finalize = _descriptor->Finalize;
+						_instancecount = _descriptor->InstanceCount;	attach = _descriptor->AttachTrace;
+					}
+					else {
+						_createinstance = (__DllCreateInstance)dlsym(_handle, "DllCreateInstance");
+						_createinstancebatch = (__DllCreateInstanceBatch)dlsym(_handle, "DllCreateInstanceBatch");
+						_canunloadnow = (__DllCanUnloadNow)dlsym(_handle, "DllCanUnloadNow");
+						_registerserver = (__DllRegisterServer)dlsym(_handle, "DllRegisterServer");
+						_unregisterserver = (__DllUnRegisterServer)dlsym(_handle, "DllUnRegisterServer");
+						_install = (__DllInstallServer)dlsym(_handle, "DllInstallServer");
+						_uninstall = (__DllUnInstallServer)dlsym(_handle, "DllUnInstallServer");
+						_initialize = (__DllInitialize)dlsym(_handle, "DllInitialize");
+						_finalize = (__DllFinalize)dlsym(_handle, "DllFinalize");
+						_instancecount = (__DllInstanceCount)dlsym(_handle, "DllInstanceCount");
+						attach = (__DllAttachTrace)dlsym(_handle, "DllAttachTrace");
+					}
 					if (_createinstance == nullptr || _canunloadnow == nullptr || _registerserver == nullptr || _unregisterserver == nullptr) {
 						__unload();
 						throw std::system_error(EFAULT, std::system_category(), "One or many function not exported from server (DllCreateInstance, DllCanUnloadNow, DllRegisterServer, DllUnInstallServer)");
 					}
+					/* Server trace records go to the client's rings, one dump covers both */
+					if (attach != nullptr) { (*attach)(Trace::Tracer::Current()); }
+					if (_host != nullptr && _initialize != nullptr && !(*_initialize)(_host)) {
+						DOM_ERR("DllInitialize of `%s` failed", _soname.c_str());
+					}
+					_loadnanos = Statistics::Now() - start;
+					_loads.fetch_add(1, std::memory_order_relaxed);
+					_loaded.store(true);
 				}
 			}
 
 		public:
-			Dll() : _handle(nullptr), _soname(), _createinstance(nullptr), _canunloadnow(nullptr),
-				_registerserver(nullptr), _unregisterserver(nullptr), _install(nullptr), _uninstall(nullptr), _initialize(nullptr), _finalize(nullptr) {
+			Dll() : _handle(nullptr), _soname(), _createinstance(nullptr), _createinstancebatch(nullptr), _canunloadnow(nullptr),
+				_registerserver(nullptr), _unregisterserver(nullptr), _install(nullptr), _uninstall(nullptr), _initialize(nullptr), _finalize(nullptr), _instancecount(nullptr), _descriptor(nullptr), _loaded(false), _loadnanos(0),
+				_activity(), _pins(0), _loads(0), _unloads(0), _reclaimed(0), _resident(false), _sweepcalls(0), _idlesince(0), _drainedcalls(0), _drained(false), _host(nullptr) {
 				;
 			}
-			Dll(std::string so) :
-				_handle(nullptr), _soname(so), _createinstance(nullptr), _canunloadnow(nullptr),
-				_registerserver(nullptr), _unregisterserver(nullptr), _install(nullptr), _uninstall(nullptr), _initialize(nullptr), _finalize(nullptr) {
-				__load();
+			Dll(std::string so, LoadMode mode = LoadMode::Eager, IUnknown* host = nullptr) :
+				_handle(nullptr), _soname(so), _createinstance(nullptr), _createinstancebatch(nullptr), _canunloadnow(nullptr),
+				_registerserver(nullptr), _unregisterserver(nullptr), _install(nullptr), _uninstall(nullptr), _initialize(nullptr), _finalize(nullptr), _instancecount(nullptr), _descriptor(nullptr), _loaded(false), _loadnanos(0),
+				_activity(), _pins(0), _loads(0), _unloads(0), _reclaimed(0), _resident(false), _sweepcalls(0), _idlesince(0), _drainedcalls(0), _drained(false), _host(host) {
+				if (mode == LoadMode::Eager) {
+					__load();
+				}
+			}
+			
+			/* Server linked into the executable: open from the start, never swept nor closed */
+			Dll(const LinkedServer& linked, IUnknown* host = nullptr) :
+				_handle(nullptr), _soname(linked.Name), _createinstance(linked.CreateInstance), _createinstancebatch(linked.CreateInstanceBatch), _canunloadnow(linked.CanUnloadNow),
+				_registerserver(linked.RegisterServer), _unregisterserver(linked.UnRegisterServer), _install(linked.InstallServer), _uninstall(linked.UnInstallServer), _initialize(linked.Initialize), _finalize(linked.Finalize), _instancecount(linked.InstanceCount), _descriptor(nullptr), _loaded(true), _loadnanos(0),
+				_activity(), _pins(0), _loads(0), _unloads(0), _reclaimed(0), _resident(true), _sweepcalls(0), _idlesince(0), _drainedcalls(0), _drained(false), _host(host) {
+				;
 			}
 			
-			~Dll() { __unload(); }
+			/* A module that may go is finalized first, activation caches are torn down inside it */
+			~Dll() {
+				if (_handle != nullptr && _finalize != nullptr && (*_canunloadnow)()) (*_finalize)(_host);
+				__unload();
+			}
 
 			Dll(const Dll& so) = delete;
-
-			Dll(const Dll&& so) {
-				_handle = so._handle;
-				_soname = move(so._soname);
-				_createinstance = so._createinstance;
-				_canunloadnow = so._canunloadnow;
-				_registerserver = so._registerserver;
-				_unregisterserver = so._unregisterserver;
-				_install = so._install;
-				_uninstall = so._uninstall;
-				_initialize = so._initialize;
-				_finalize = so._finalize;
-			}
+			Dll(Dll&& so) = delete;
 
 			inline operator bool() { return _handle != nullptr; }
 
 			const Dll& operator = (const Dll& so) = delete;
-			inline const Dll& operator = (const Dll&& so) {
-				_handle = so._handle;
-				_soname = move(so._soname);
-				_createinstance = so._createinstance;
-				_canunloadnow = so._canunloadnow;
-				_registerserver = so._registerserver;
-				_unregisterserver = so._unregisterserver;
-				_install = so._install;
-				_uninstall = so._uninstall;
-				_initialize = so._initialize;
-				_finalize = so._finalize;
+			const Dll& operator = (Dll&& so) = delete;
+
+			/* Opens the server exactly once, concurrent callers wait for the first one; throws like the eager constructor */
+			inline void Load() {
+				if (!_loaded.load(std::memory_order_acquire)) {
+					std::unique_lock<std::mutex> lock(_lock);
+					__load();
+				}
+			}
+			inline bool IsLoaded() const { return _loaded.load(std::memory_order_acquire); }
+			/* The IUnknown servers get in DllInitialize: initializes an open server at once, later loads on open */
+			inline void Host(IUnknown* host) {
+				std::unique_lock<std::mutex> lock(_lock);
+				_host = host;
+				if (_host != nullptr && _initialize != nullptr && _loaded.load()) (*_initialize)(_host);
+			}
+			inline const std::string& SoName() const { return _soname; }
+			/* Static description of the server, nullptr if it exports none; points into the module, valid while it is open */
+			inline const ServerDescriptor* Descriptor() { Load(); return _descriptor; }
+
+			inline bool CreateInstance(const clsuid& id, void** ppv) { Call call(*this); return (*_createinstance)(id, ppv); }
+			/* Raw entry points stay valid only while the module is pinned */
+			inline void Pin() {
+				_pins.fetch_add(1);
+				if (!_loaded.load()) {
+					try { Load(); }
+					catch (...) { _pins.fetch_sub(1); throw; }
+				}
+			}
+			inline void Unpin() { _pins.fetch_sub(1); }
+			inline __DllCreateInstance CreateInstanceEntry() { Load(); return _createinstance; }
+			/* Optional export, nullptr for servers built before it existed */
+			inline __DllCreateInstanceBatch CreateInstanceBatchEntry() { Load(); return _createinstancebatch; }
+			inline size_t CreateInstances(const clsuid& id, size_t count, void** ppv) { Call call(*this); return CreateInstances(_createinstance, _createinstancebatch, id, count, ppv); }
+			/* Falls back to one DllCreateInstance per object; stops at the first failure and returns the number created */
+			static inline size_t CreateInstances(__DllCreateInstance create, __DllCreateInstanceBatch batch, const clsuid& id, size_t count, void** ppv) {
+				if (batch != nullptr) return (*batch)(id, count, ppv);
+				size_t n = 0;
+				std::fill(ppv, ppv + count, nullptr);
+				for (; n < count && (*create)(id, ppv + n); n++) { ; }
+				return n;
+			}
+			inline bool CanUnloadNow() { return IfLoaded([&]() { return (*_canunloadnow)(); }, true); }
+			inline bool RegisterServer(IUnknown* unkn, std::string&& scope) { Call call(*this); return (*_registerserver)(unkn, std::move(scope)); }
+			inline bool UnRegisterServer(IUnknown* unkn, std::string&& scope) { Call call(*this); return (*_unregisterserver)(unkn, std::move(scope)); }
+			inline bool InstallServer(IUnknown* unkn) { Call call(*this); return _install != nullptr ? (*_install)(unkn) : true; }
+			inline bool UnInstallServer(IUnknown* unkn) { Call call(*this); return _uninstall != nullptr ? (*_uninstall)(unkn) : true; }
+			inline bool Initialize(IUnknown* unkn) { Call call(*this); return _initialize != nullptr ? (*_initialize)(unkn) : true; }
+			inline bool Finalize(IUnknown* unkn) { return IfLoaded([&]() { return _finalize != nullptr ? (*_finalize)(unkn) : true; }, true); }
+			/* Live objects of a class, -1 if the server does not count them; never loads the server */
+			inline long InstanceCount(const clsuid& id) { return IfLoaded([&]() { return _instancecount != nullptr ? (*_instancecount)(id) : -1L; }, 0L); }
+			inline uint64_t LoadNanos() const { return _loadnanos.load(std::memory_order_relaxed); }
+			inline uint64_t Loads() const { return _loads.load(std::memory_order_relaxed); }
+			inline uint64_t Unloads() const { return _unloads.load(std::memory_order_relaxed); }
+			inline uint64_t ReclaimedBytes() const { return _reclaimed.load(std::memory_order_relaxed); }
+
+			/* Sweep pass bookkeeping: true once the module has been open without a single call for `idle` ns */
+			inline bool Idle(uint64_t now, uint64_t idle) {
+				if (!IsLoaded() || _resident) { _idlesince = 0; return false; }
+				auto calls = Calls();
+				if (_idlesince == 0 || calls != _sweepcalls) { _sweepcalls = calls; _idlesince = now; }
+				return now - _idlesince >= idle;
+			}
+
+			/* Finalizes and closes the module if no call is in flight, no factory pins it and it has no live objects, on the second
+			   of two passes that both find it so without a call in between. An object's final Release drops the live count before
+			   it returns through module code, outside any Call: the time between the two passes is its grace to leave.
+			   It stays usable: the next call reopens it. `reclaimed` is the drop of the process resident set */
+			inline bool Sweep(IUnknown* unkn, uint64_t& reclaimed) {
+				std::unique_lock<std::mutex> lock(_lock);
+				if (_handle == nullptr || _resident || _pins.load() != 0) { _drained = false; return false; }
+				_loaded.store(false);
+				if (Inflight() != 0 || _pins.load() != 0 || !(*_canunloadnow)()) {
+					_loaded.store(true);
+					_drained = false;
+					return false;
+				}
+				auto calls = Calls();
+				if (!_drained || _drainedcalls != calls) {
+					_loaded.store(true);
+					_drained = true;
+					_drainedcalls = calls;
+					return false;
+				}
+				_drained = false;
+				auto before = ResidentBytes();
+				if (_finalize != nullptr) (*_finalize)(unkn);
+				__unload();
+				if (auto mapped = dlopen(_soname.c_str(), RTLD_NOW | RTLD_NOLOAD)) {
+					dlclose(mapped);
+					_resident = true;
+					DOM_ERR("Server `%s` stays mapped after dlclose (STB_GNU_UNIQUE symbols?), build it with -fno-gnu-unique to make it sweepable", _soname.c_str());
+				}
+				auto after = ResidentBytes();
+				reclaimed = before > after ? before - after : 0;
+				_unloads.fetch_add(1, std::memory_order_relaxed);
+				_reclaimed.fetch_add(reclaimed, std::memory_order_relaxed);
+				_idlesince = 0;
+				DOM_CALL_TRACE("%s %lu bytes", _soname.c_str(), reclaimed);
+				return true;
+			}
+
+		};
+
+		/* Resolved (class, scope) -> server binding, shared by every snapshot that still holds the class, by factory handles
+		   and by calls in progress */
+		struct ClassBinding : public std::enable_shared_from_this<ClassBinding> {
+			clsuid					ClsId;
+			std::string				Scope;
+			ScopeId					ScopeKey;
+			std::string				SoPathName;
+			std::shared_ptr<Dll>	Server;
+			std::atomic_bool		Valid;
+			mutable std::atomic<ClassStatistics*>	Counters;
+			/* Class factories of a linked server, called directly; nullptr for module classes */
+			bool(*Create)(const clsuid& iid, void** ppv);
+			size_t(*CreateBatch)(const clsuid& iid, size_t count, void** ppv);
+			/* Host process of an out-of-process server, objects are proxies; Server is then a resident placeholder */
+			std::shared_ptr<Remote::Channel>	Remote;
+
+			ClassBinding(const clsuid& cid, const std::string& scope, const std::string& so, const std::shared_ptr<Dll>& server)
+				: ClsId(cid), Scope(scope), ScopeKey(scope), SoPathName(so), Server(server), Valid(true), Counters(nullptr), Create(nullptr), CreateBatch(nullptr) { ; }
+			ClassBinding(const LinkedClass& cls, const std::shared_ptr<Dll>& server)
+				: ClsId(cls.ClsId), Scope(), ScopeKey(ScopeId::Global()), SoPathName(server->SoName()), Server(server), Valid(true), Counters(nullptr), Create(cls.Create), CreateBatch(cls.CreateBatch) { ; }
+			~ClassBinding() { delete Counters.load(); }
+
+			inline bool CreateInstance(void** ppv) const {
+				return Create != nullptr ? (*Create)(IUnknown::guid(), ppv) : Remote ? Remote->CreateInstance(ClsId, ppv) : Server->CreateInstance(ClsId, ppv);
+			}
+			inline size_t CreateInstances(size_t count, void** ppv) const {
+				return CreateBatch != nullptr ? (*CreateBatch)(IUnknown::guid(), count, ppv) : Remote ? Remote->CreateInstances(ClsId, count, ppv) : Server->CreateInstances(ClsId, count, ppv);
+			}
+
+			/* With `track` the counters are allocated on first use, otherwise only existing ones are updated */
+			inline void Count(size_t created, size_t failed, bool track) const {
+				auto counters = Counters.load(std::memory_order_acquire);
+				if (counters == nullptr) {
+					if (!track) return;
+					auto fresh = new ClassStatistics();
+					if (Counters.compare_exchange_strong(counters, fresh, std::memory_order_acq_rel)) counters = fresh; else delete fresh;
+				}
+				auto&& local = counters->Local();
+				if (created) local.Creates.fetch_add(created, std::memory_order_relaxed);
+				if (failed) local.Failures.fetch_add(failed, std::memory_order_relaxed);
+			}
+		};
+
+		/* An attached registry index with the classes bound from it on first use. Shared by every snapshot that attaches the same
+		   index: a first use fills the class's slot under `lock` instead of copying and republishing the table, so warming up N
+		   indexed classes costs O(N) rather than N table copies and grace periods */
+		class IndexedClasses {
+			std::shared_ptr<const RegistryIndex>					index;
+			std::unique_ptr<std::atomic<const ClassBinding*>[]>		slots;
+			std::mutex												lock;
+			/* Bindings in a slot, and those taken out of one: a reader of an older snapshot may still hold a pointer to them
+			   until the next grace period, Reclaim() frees them after it */
+			std::vector<std::shared_ptr<ClassBinding>>				bound, retired;
+			/* Servers of bound classes the table did not have */
+			std::unordered_map<std::string, std::shared_ptr<Dll>>	servers;
+
+			inline std::atomic<const ClassBinding*>& Slot(const RegistryIndex::Class* cls) const { return slots[cls - index->begin()]; }
+			/* Lets go of the servers no bound class uses any more */
+			inline void Prune() {
+				std::unordered_set<const Dll*> used;
+				for (auto&& binding : bound) used.insert(binding->Server.get());
+				for (auto&& it = servers.begin(); it != servers.end();) {
+					if (used.count(it->second.get())) ++it; else it = servers.erase(it);
+				}
+			}
+		public:
+			/* Takes over the bindings of `previous`, the index this one replaces, whose class it still lists; the rest go stale */
+			IndexedClasses(const std::shared_ptr<const RegistryIndex>& idx, IndexedClasses* previous = nullptr)
+				: index(idx), slots(new std::atomic<const ClassBinding*>[idx->end() - idx->begin()]()) {
+				if (previous == nullptr) return;
+				std::unique_lock<std::mutex> sync(previous->lock);
+				servers = previous->servers;
+				for (auto&& binding : previous->bound) {
+					if (auto cls = index->Find(binding->ClsId, binding->Scope)) { Slot(cls).store(binding.get(), std::memory_order_relaxed); bound.push_back(binding); }
+					else binding->Valid = false;
+				}
+				Prune();
+			}
+			IndexedClasses(const IndexedClasses&) = delete;
+
+			inline const RegistryIndex& Index() const { return *index; }
+			inline const ClassBinding* Bound(const RegistryIndex::Class* cls) const { return Slot(cls).load(std::memory_order_acquire); }
+
+			/* Binding of `cls`, made by `make(servers)` if the class has none yet */
+			template<typename FN>
+			inline std::shared_ptr<ClassBinding> Bind(const RegistryIndex::Class* cls, FN&& make) {
+				std::unique_lock<std::mutex> sync(lock);
+				auto&& slot = Slot(cls);
+				if (auto binding = slot.load(std::memory_order_relaxed)) return std::const_pointer_cast<ClassBinding>(binding->shared_from_this());
+				auto binding = make(servers);
+				if (binding) { bound.push_back(binding); slot.store(binding.get(), std::memory_order_release); }
+				return binding;
+			}
+			/* Class unregistered: its handles go stale, a later first use binds it again if the index still lists it */
+			inline bool Unbind(const clsuid& cid, const std::string& scope) {
+				auto cls = index->Find(cid, scope);
+				if (cls == nullptr) return false;
+				std::unique_lock<std::mutex> sync(lock);
+				auto binding = Slot(cls).exchange(nullptr, std::memory_order_acq_rel);
+				if (binding == nullptr) return false;
+				auto&& it = std::find_if(bound.begin(), bound.end(), [&](const std::shared_ptr<ClassBinding>& b) { return b.get() == binding; });
+				(*it)->Valid = false;
+				retired.push_back(std::move(*it));
+				bound.erase(it);
+				return true;
+			}
+
+			/* Writer side, once a grace period has passed since the last Unbind */
+			inline void Reclaim() {
+				std::unique_lock<std::mutex> sync(lock);
+				if (retired.empty()) return;
+				retired.clear();
+				Prune();
+			}
+
+			inline std::shared_ptr<Dll> Server(const std::string& real) {
+				std::unique_lock<std::mutex> sync(lock);
+				auto&& it = servers.find(real);
+				return it != servers.end() ? it->second : nullptr;
+			}
+			/* Appends what is bound so far */
+			inline void Collect(std::vector<std::shared_ptr<ClassBinding>>& classes, std::vector<std::pair<std::string, std::shared_ptr<Dll>>>& so) {
+				std::unique_lock<std::mutex> sync(lock);
+				classes.insert(classes.end(), bound.begin(), bound.end());
+				so.insert(so.end(), servers.begin(), servers.end());
+			}
+		};
+
+		/* (class, interned scope), the lookup key of a binding */
+		struct ClassKey {
+			uint64_t	cid;
+			ScopeId		scope;
+
+			inline bool operator == (const ClassKey& WithThis) const { return cid == WithThis.cid && scope == WithThis.scope; }
+			struct Hash {
+				inline size_t operator()(const ClassKey& key) const { return key.cid ^ (key.scope.hash() * 0x9e3779b97f4a7c15ull); }
+			};
+		};
+
+		/* Immutable snapshot of the class table, published to CreateInstance readers */
+		struct ClassTable {
+			/* Every publish gets a new, process-wide unique version */
+			uint64_t																Version = NextVersion();
+			std::unordered_multimap<clsuid, std::shared_ptr<ClassBinding>, Dom::GUID::Hash, Dom::GUID::Equal>	listClasses;
+			/* Same bindings by (class, scope): one hash probe however many scopes a class is registered in */
+			std::unordered_map<ClassKey, std::shared_ptr<ClassBinding>, ClassKey::Hash>	listBindings;
+			std::unordered_map<std::string, std::shared_ptr<Dll>>					listServers;
+			/* Registry indexes queried in place; their classes are bound on first use, beside the table */
+			std::vector<std::pair<std::string, std::shared_ptr<IndexedClasses>>>		listIndexes;
+			/* Classes removed since the indexes were built */
+			std::set<std::pair<uint64_t, std::string>>								listRemoved;
+			/* Classes of servers linked into the executable, resolved before any scope */
+			std::unordered_map<clsuid, std::shared_ptr<ClassBinding>, Dom::GUID::Hash, Dom::GUID::Equal>	listLinked;
+
+			/* What the servers of this table get in DllInitialize */
+			IUnknown*																Host = nullptr;
+
+			/* Binds every class of Dom::LinkedServers, one Dll per linked server */
+			inline void Link() {
+				for (auto&& cls : LinkedServers::Instance().Classes()) {
+					auto&& so = listServers.emplace(cls.Server->Name, nullptr).first->second;
+					if (!so) so = std::make_shared<Dll>(*cls.Server, Host);
+					auto binding = std::make_shared<ClassBinding>(cls, so);
+					if (listLinked.emplace(cls.ClsId, binding).second) {
+						listClasses.emplace(cls.ClsId, std::move(binding));
+					}
+				}
+			}
+
+			/* Keyed by the resolved path: classes reached through different registry links share one Dll and one dlopen */
+			inline const std::shared_ptr<Dll>& EmplaceServer(const std::string& so, LoadMode mode = LoadMode::Eager) {
+				auto real = RealPath(so);
+				auto&& it = listServers.find(real);
+				if (it == listServers.end()) {
+					it = listServers.emplace(real, IndexedServer(real)).first;
+					if (!it->second) it->second = std::make_shared<Dll>(real, mode, Host);
+					else if (mode == LoadMode::Eager) it->second->Load();
+				}
+				return it->second;
+			}
+			/* The Dll a class bound from an index already opened `real` with, if any */
+			inline std::shared_ptr<Dll> IndexedServer(const std::string& real) const {
+				for (auto&& it : listIndexes) {
+					if (auto so = it.second->Server(real)) return so;
+				}
+				return nullptr;
+			}
+			/* Takes a server opened outside the lock, unless the table already has one for the same module */
+			inline const std::shared_ptr<Dll>& EmplaceServer(const std::string& so, const std::shared_ptr<Dll>& loaded) {
+				auto&& it = listServers.emplace(RealPath(so), loaded);
+				if (it.second) loaded->Host(Host);
+				return it.first->second;
+			}
+			/* Placeholder of a server running in a host process: open and resident, so it is neither loaded nor swept here */
+			inline const std::shared_ptr<Dll>& EmplaceRemote(const std::string& so) {
+				auto&& it = listServers.find(so);
+				if (it == listServers.end()) {
+					LinkedServer placeholder = { so.c_str(), nullptr, nullptr, []() { return true; }, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+					it = listServers.emplace(so, std::make_shared<Dll>(placeholder)).first;
+				}
+				return it->second;
+			}
+
+			static inline uint64_t NextVersion() { static std::atomic<uint64_t> version(0); return version.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+			inline const ClassBinding* Find(const clsuid& cid, ScopeId scope) const {
+				auto&& it = listBindings.find(ClassKey{ (uint64_t)cid.hash(), scope });
+				return it != listBindings.end() ? it->second.get() : nullptr;
+			}
+
+			inline std::shared_ptr<ClassBinding> Binding(const clsuid& cid, ScopeId scope) const {
+				auto&& it = listBindings.find(ClassKey{ (uint64_t)cid.hash(), scope });
+				return it != listBindings.end() ? it->second : nullptr;
+			}
+
+			inline const RegistryIndex::Class* Indexed(const clsuid& cid, std::string_view scope, IndexedClasses** index = nullptr) const {
+				if (!listRemoved.empty() && listRemoved.count(std::make_pair((uint64_t)cid.hash(), std::string(scope)))) return nullptr;
+				for (auto&& it : listIndexes) {
+					if (auto cls = it.second->Index().Find(cid, scope)) {
+						if (index != nullptr) *index = it.second.get();
+						return cls;
+					}
+				}
+				return nullptr;
+			}
+
+			/* A refreshed index keeps the bindings of the classes it still lists */
+			inline void AttachIndex(const std::string& RegistryPath, const std::shared_ptr<const RegistryIndex>& index) {
+				auto&& it = std::find_if(listIndexes.begin(), listIndexes.end(), [&](const std::pair<std::string, std::shared_ptr<IndexedClasses>>& i) { return i.first == RegistryPath; });
+				if (it != listIndexes.end()) {
+					if (index) it->second = std::make_shared<IndexedClasses>(index, it->second.get()); else listIndexes.erase(it);
+				}
+				else if (index) {
+					listIndexes.emplace_back(RegistryPath, std::make_shared<IndexedClasses>(index));
+				}
+			}
+
+			/* Every binding and every server, the table's and those bound from its indexes so far */
+			inline void Collect(std::vector<std::shared_ptr<ClassBinding>>& classes, std::vector<std::pair<std::string, std::shared_ptr<Dll>>>& servers) const {
+				for (auto&& it : listClasses) classes.push_back(it.second);
+				servers.assign(listServers.begin(), listServers.end());
+				for (auto&& it : listIndexes) it.second->Collect(classes, servers);
+				std::unordered_set<const Dll*> unique;
+				servers.erase(std::remove_if(servers.begin(), servers.end(), [&](const std::pair<std::string, std::shared_ptr<Dll>>& so) { return !unique.insert(so.second.get()).second; }), servers.end());
+			}
+
+			/* Ids are compared by hash alone: another name with the hash of a registered class would shadow it */
+			inline bool Collides(const clsuid& cid) const {
+				auto&& it = listClasses.find(cid);
+				if (it == listClasses.end() || !it->first.collides(cid)) return false;
+				DOM_ERR("Class `%s` collides with a registered class id", cid.c_str());
+				return true;
+			}
+			/* Bind, unless the class id collides with a registered one */
+			inline bool Insert(const clsuid& cid, const std::string& scope, const std::string& so, LoadMode mode = LoadMode::Eager) {
+				return !Collides(cid) && Bind(cid, scope, so, mode);
+			}
+			inline bool Insert(const clsuid& cid, const std::string& scope, const std::string& so, const std::shared_ptr<Remote::Channel>& channel) {
+				return !Collides(cid) && Bind(cid, scope, so, channel);
+			}
+
+			/* Re-binding the same (class, scope, server) keeps the existing binding, so resolved handles survive reloads */
+			inline bool Bind(const clsuid& cid, const std::string& scope, const std::string& so, LoadMode mode = LoadMode::Eager) {
+				if (auto binding = Binding(cid, ScopeId::Lookup(scope))) {
+					if (binding->SoPathName == so) return true;
+					Unbind(cid, scope);
+				}
+				/* Interned copy: a server literal id lives in the module, which the idle sweeper may close */
+				auto binding = std::make_shared<ClassBinding>(clsuid(std::string(cid.c_str(), cid.length())), scope, so, EmplaceServer(so, mode));
+				listBindings.emplace(ClassKey{ (uint64_t)cid.hash(), binding->ScopeKey }, binding);
+				listClasses.emplace(binding->ClsId, std::move(binding));
+				return true;
+			}
+
+			/* Class of an out-of-process server, `so` is its `remote:` name */
+			inline bool Bind(const clsuid& cid, const std::string& scope, const std::string& so, const std::shared_ptr<Remote::Channel>& channel) {
+				if (auto binding = Binding(cid, ScopeId::Lookup(scope))) {
+					if (binding->Remote == channel) return true;
+					Unbind(cid, scope);
+				}
+				auto binding = std::make_shared<ClassBinding>(cid, scope, so, EmplaceRemote(so));
+				binding->Remote = channel;
+				listBindings.emplace(ClassKey{ (uint64_t)cid.hash(), binding->ScopeKey }, binding);
+				listClasses.emplace(binding->ClsId, std::move(binding));
+				return true;
+			}
+
+			inline bool Unbind(const clsuid& cid, const std::string& scope) {
+				bool indexed = false;
+				for (auto&& index : listIndexes) { indexed = index.second->Unbind(cid, scope) || indexed; }
+				auto&& it = listBindings.find(ClassKey{ (uint64_t)cid.hash(), ScopeId::Lookup(scope) });
+				if (it == listBindings.end()) return indexed;
+				auto&& range = listClasses.equal_range(cid);
+				for (auto&& cls = range.first; cls != range.second; cls++) {
+					if (cls->second == it->second) { listClasses.erase(cls); break; }
+				}
+				it->second->Valid = false;
+				listBindings.erase(it);
+				return true;
+			}
+		};
+
+		/* Per-thread memo of hierarchical scope fallbacks: (table version, class, scope) -> binding of the nearest ancestor scope,
+		   misses included. Trivially destructible like QueryCache; every table update publishes a new version */
+		class ScopeMemo {
+			struct Entry {
+				uint64_t				version;
+				uint64_t				cid;
+				ScopeId					scope;
+				const ClassBinding*		binding;
+			};
+			static constexpr size_t Size = 256;
+			struct Table {
+				Entry	entries[Size];
+			};
+		public:
+			static inline Entry& Slot(uint64_t cid, ScopeId scope) {
+				static thread_local Table table;
+				return table.entries[(cid ^ scope.hash()) & (Size - 1)];
+			}
+			static inline bool Match(const Entry& e, uint64_t version, uint64_t cid, ScopeId scope) { return e.version == version && e.cid == cid && e.scope == scope; }
+		};
+
+		/* Resolved class handle: pins the server and calls its DllCreateInstance directly, turns stale once the class is unregistered */
+		class ClassFactory {
+			std::shared_ptr<ClassBinding>	binding;
+			__DllCreateInstance				create;
+			__DllCreateInstanceBatch		batch;
+		public:
+			ClassFactory() : binding(), create(nullptr), batch(nullptr) { ; }
+			ClassFactory(const std::shared_ptr<ClassBinding>& cls) : binding(cls), create(nullptr), batch(nullptr) {
+				binding->Server->Pin();
+				create = binding->Server->CreateInstanceEntry();
+				batch = binding->Server->CreateInstanceBatchEntry();
+			}
+			ClassFactory(const ClassFactory& f) : binding(f.binding), create(f.create), batch(f.batch) { if (binding) binding->Server->Pin(); }
+			ClassFactory(ClassFactory&& f) noexcept : binding(std::move(f.binding)), create(f.create), batch(f.batch) { f.create = nullptr; f.batch = nullptr; }
+			~ClassFactory() { if (binding) binding->Server->Unpin(); }
+			inline ClassFactory& operator = (ClassFactory f) noexcept {
+				std::swap(binding, f.binding); std::swap(create, f.create); std::swap(batch, f.batch);
 				return *this;
 			}
-			inline bool CreateInstance(const clsuid& id, void** ppv) { return (*_createinstance)(id, ppv); }
-			inline bool CanUnloadNow() { return (*_canunloadnow)(); }
-			inline bool RegisterServer(IUnknown* unkn, std::string&& scope) { return (*_registerserver)(unkn, std::move(scope)); }
-			inline bool UnRegisterServer(IUnknown* unkn, std::string&& scope) { return (*_unregisterserver)(unkn, std::move(scope)); }
-			inline bool InstallServer(IUnknown* unkn) { return _install != nullptr ? (*_install)(unkn) : true; }
-			inline bool UnInstallServer(IUnknown* unkn) { return _uninstall != nullptr ? (*_uninstall)(unkn) : true; }
-			inline bool Initialize(IUnknown* unkn) { return _initialize != nullptr ? (*_initialize)(unkn) : true; }
-			inline bool Finalize(IUnknown* unkn) { return _finalize != nullptr ? (*_finalize)(unkn) : true; }
 
+			inline operator bool() const { return binding && binding->Valid.load(std::memory_order_relaxed); }
+			inline bool Stale() const { return !(bool)*this; }
+			inline const clsuid& guid() const { return binding->ClsId; }
+
+			/* Returns an AddRef'd IUnknown */
+			inline bool CreateInstance(void** ppv) const {
+				*ppv = nullptr;
+				if (!*this) return false;
+				bool created = create != nullptr ? (*create)(binding->ClsId, ppv) : binding->CreateInstance(ppv);
+				binding->Count(created, !created, false);
+				return created;
+			}
+			/* Fills `ppv` with up to `count` AddRef'd IUnknown, returns how many were created */
+			inline size_t CreateInstances(size_t count, void** ppv) const {
+				if (!*this) { std::fill(ppv, ppv + count, nullptr); return 0; }
+				auto created = create != nullptr ? Dll::CreateInstances(create, batch, binding->ClsId, count, ppv) : binding->CreateInstances(count, ppv);
+				binding->Count(created, count - created, false);
+				return created;
+			}
+			template<typename T>
+			inline Interface<T> Create() const {
+				Interface<T> result;
+				IUnknown* unkn;
+				if (CreateInstance((void**)&unkn)) {
+					result.Attach(unkn);
+				}
+				return result;
+			}
 		};
 
 		template<typename ... IFACES>
-		class Manager : virtual public IUnknown, public IFACES... {
+		class Manager : virtual public IUnknown, public IStatistics, public IFACES... {
 		private:
 			std::mutex																listLock;
-			std::unordered_multimap<clsuid, std::pair<std::string, std::string>, Dom::GUID::Hash, Dom::GUID::Equal>	listClasses;
-			std::unordered_map<std::string, Dll>									listServers;
+			Statistics																statistics;
+			Rcu<const ClassTable>													listTable;
+			std::mutex																watchLock;
+			std::unique_ptr<RegistryWatcher>										watchRegistry;
+			std::vector<std::string>												watchRoots;
+			std::thread																watchThread;
+			std::atomic_bool														watchStop;
+			std::mutex																workersLock;
+			std::unique_ptr<WorkerPool>												workersPool;
+			std::atomic_bool														scopeFallback;
+			std::mutex																sweepLock;
+			std::mutex																sweeperLock;
+			std::condition_variable													sweeperWake;
+			std::thread																sweeperThread;
+			bool																	sweeperStop;
+			std::atomic<IAllocator*>												allocator;
+
+			static inline ClassTable* Linked(IUnknown* host) { auto table = new ClassTable(); table->Host = host; table->Link(); return table; }
+
+			/* Started by the first bulk call */
+			inline WorkerPool& Workers() {
+				std::unique_lock<std::mutex> lock(workersLock);
+				if (!workersPool) workersPool.reset(new WorkerPool());
+				return *workersPool;
+			}
+
+			/* Applies symlink deltas in one snapshot update; `rescanned` roots drop every class that was not reported again */
+			inline void ApplyChanges(const std::vector<RegistryWatcher::Change>& changes, const std::vector<std::string>& rescanned = std::vector<std::string>()) {
+				if (changes.empty() && rescanned.empty()) return;
+				Update([&](ClassTable& table) {
+					for (auto&& root : rescanned) {
+						std::vector<std::pair<clsuid, std::string>> stale;
+						for (auto&& cls : table.listClasses) {
+							auto&& so = cls.second->SoPathName;
+							if (so.compare(0, root.length(), root) == 0 && std::none_of(changes.begin(), changes.end(), [&](const RegistryWatcher::Change& c) { return c.SoPathName == so; })) {
+								stale.emplace_back(cls.first, cls.second->Scope);
+							}
+						}
+						for (auto&& cls : stale) { table.Unbind(cls.first, cls.second); table.listRemoved.emplace(cls.first.hash(), cls.second); }
+					}
+					for (auto&& change : changes) {
+						if (change.Name.empty()) {
+							/* Scope directory gone: the classes of the table and of the indexes linked under it */
+							auto&& prefix = change.SoPathName;
+							std::vector<std::pair<clsuid, std::string>> gone;
+							for (auto&& cls : table.listClasses) {
+								if (cls.second->SoPathName.compare(0, prefix.length(), prefix) == 0) gone.emplace_back(cls.first, cls.second->Scope);
+							}
+							for (auto&& indexed : table.listIndexes) {
+								auto&& index = indexed.second->Index();
+								for (auto&& cls : index) {
+									if (index.Value(cls.so).compare(0, prefix.length(), prefix) == 0) gone.emplace_back(clsuid(std::string(index.Value(cls.name))), std::string(index.Value(cls.scope)));
+								}
+							}
+							for (auto&& cls : gone) { table.Unbind(cls.first, cls.second); table.listRemoved.emplace(cls.first.hash(), cls.second); }
+							continue;
+						}
+						clsuid cid(change.Name);
+						if (change.Added) {
+							if (table.Insert(cid, change.Scope, change.SoPathName, LoadMode::Lazy)) {
+								table.listRemoved.erase(std::make_pair((uint64_t)cid.hash(), change.Scope));
+							}
+						}
+						else {
+							table.Unbind(cid, change.Scope);
+							table.listRemoved.emplace(cid.hash(), change.Scope);
+						}
+					}
+					return true;
+				});
+			}
+
+			/* Copy-on-write update of the class table; readers keep running against the previous snapshot */
+			template<typename FN>
+			inline auto Update(FN&& fn) -> decltype(fn(std::declval<ClassTable&>())) {
+				TimedLock lock(listLock, statistics);
+				std::unique_ptr<ClassTable> table(new ClassTable(*listTable.Peek()));
+				auto&& result = fn(*table);
+				table->Version = ClassTable::NextVersion();
+				auto publish = statistics.Start();
+				delete listTable.Publish(table.release());
+				if (publish) statistics.Published(Statistics::Now() - publish);
+				/* Publish waited out the readers that could still reach a binding unbound from an index */
+				for (auto&& it : listTable.Peek()->listIndexes) it.second->Reclaim();
+				return result;
+			}
+
+			/* Binding of (class, scope); with fallback enabled, else the one of the nearest ancestor scope (`a/b`, `a`, global),
+			   memoized per thread for the table version. `pending` names the scope to materialize when only an index knows the class.
+			   Scopes are only looked up: names nothing was bound in are walked as strings up to the first interned ancestor.
+			   The binding outlives the snapshot: callers let go of it before they call into the server */
+			inline std::shared_ptr<const ClassBinding> Resolve(const ClassTable& table, const clsuid& clsId, std::string_view Scope, ScopeId& pending) const {
+				auto clsEntry = Lookup(table, clsId, Scope, pending);
+				return clsEntry != nullptr ? clsEntry->shared_from_this() : nullptr;
+			}
+			inline const ClassBinding* Lookup(const ClassTable& table, const clsuid& clsId, std::string_view Scope, ScopeId& pending) const {
+				if (!table.listLinked.empty()) {
+					auto&& it = table.listLinked.find(clsId);
+					if (it != table.listLinked.end()) return it->second.get();
+				}
+				auto scope = ScopeId::Lookup(Scope);
+				if (scope) {
+					if (auto clsEntry = table.Find(clsId, scope)) return clsEntry;
+				}
+				bool fallback = scopeFallback.load(std::memory_order_relaxed) && !Scope.empty();
+				if (fallback && scope) {
+					auto&& memo = ScopeMemo::Slot(clsId.hash(), scope);
+					if (ScopeMemo::Match(memo, table.Version, clsId.hash(), scope)) return memo.binding;
+				}
+
+				const ClassBinding* clsEntry = nullptr;
+				auto at = scope;
+				for (auto name = Scope;; ) {
+					if (at && at != scope && (clsEntry = table.Find(clsId, at)) != nullptr) break;
+					/* A scope an index knows is interned by the bind that follows anyway */
+					IndexedClasses* indexed;
+					if (auto cls = !table.listIndexes.empty() ? table.Indexed(clsId, name, &indexed) : nullptr) {
+						if ((clsEntry = indexed->Bound(cls)) != nullptr) break;
+						pending = ScopeId(name);
+						return nullptr;
+					}
+					if (!fallback || name.empty()) break;
+					if (at) { at = at.Parent(); name = at.name(); continue; }
+					auto pos = name.rfind('/');
+					name = pos == std::string_view::npos ? std::string_view() : name.substr(0, pos);
+					at = ScopeId::Lookup(name);
+				}
+				if (fallback && scope) ScopeMemo::Slot(clsId.hash(), scope) = { table.Version, clsId.hash(), scope, clsEntry };
+				return clsEntry;
+			}
+
+			inline bool Created(const ClassBinding* cls, bool created, uint64_t start) {
+				cls->Count(created, !created, start != 0);
+				statistics.Created(start);
+				return created;
+			}
+
+			/* Fresh index of the registry tree, rebuilt when stale or missing; nullptr means walk the tree */
+			static inline std::shared_ptr<const RegistryIndex> OpenIndex(const std::string& RegistryPath) {
+				auto index = std::make_shared<const RegistryIndex>(RegistryPath);
+				if (!index->Fresh(RegistryPath) && RegistryIndex::Build(RegistryPath)) {
+					index = std::make_shared<const RegistryIndex>(RegistryPath);
+				}
+				return index->Fresh(RegistryPath) ? index : nullptr;
+			}
+
+			/* Registry changed on disk: rebuild its index and swap it into the table if this manager uses it */
+			inline void RefreshIndex(const std::string& RegistryPath) {
+				auto index = RegistryIndex::Build(RegistryPath) ? std::make_shared<const RegistryIndex>(RegistryPath) : nullptr;
+				bool attached = false;
+				{
+					auto table = listTable.Read();
+					for (auto&& it : table->listIndexes) { attached = attached || it.first == RegistryPath; }
+				}
+				if (attached) {
+					Update([&](ClassTable& table) { table.AttachIndex(RegistryPath, index && index->Valid() ? index : nullptr); return true; });
+				}
+			}
+
+			/* Binds an indexed class on its first use, in the slot its index keeps for it: nothing is copied nor published */
+			inline std::shared_ptr<ClassBinding> Materialize(const clsuid& clsId, const std::string& Scope) {
+				auto table = listTable.Read();
+				if (auto binding = table->Binding(clsId, ScopeId::Lookup(Scope))) return binding;
+				IndexedClasses* indexed;
+				auto cls = table->Indexed(clsId, Scope, &indexed);
+				if (cls == nullptr) return nullptr;
+				if (table->Collides(clsId)) return nullptr;
+				return indexed->Bind(cls, [&](std::unordered_map<std::string, std::shared_ptr<Dll>>& servers) {
+					std::string so(indexed->Index().Value(cls->so));
+					auto real = RealPath(so);
+					auto&& it = table->listServers.find(real);
+					auto&& server = servers.emplace(real, it != table->listServers.end() ? it->second : nullptr).first->second;
+					if (!server) server = std::make_shared<Dll>(real, LoadMode::Lazy, table->Host);
+					/* Interned copy: a server literal id lives in the module, which the idle sweeper may close */
+					return std::make_shared<ClassBinding>(clsuid(std::string(clsId.c_str(), clsId.length())), Scope, so, server);
+				});
+			}
+			/* Binds every class link found under RegistryPath, its scope is the link directory relative to the registry */
+			static inline void ScanRegistry(const std::string& RegistryPath, ClassTable& table, LoadMode Mode) {
+				EnumFiles(RegistryPath, [&](const std::string& fullpath, const dirent& e) {
+					if (e.d_type & DT_LNK) {
+						auto ScopeName = fullpath.substr(RegistryPath.length());
+						std::string Scope;
+						size_t pos = ScopeName.rfind('/');
+						if (pos != std::string::npos) {
+							Scope = ScopeName.substr(0, pos);
+						}
+						table.Insert(clsuid(e.d_name), Scope, fullpath, Mode);
+					}
+				});
+			}
 			class CSharedServer : virtual public IUnknown, virtual public IRegistry {
 				std::string SoPathName, RegistryPath;
+				/* Classes already in the registry, read on the first RegisterClass; servers are never opened from it */
+				std::unique_ptr<ClassTable> registry;
 			public:
+				std::forward_list<std::pair<clsuid, std::string>> Removed;
+
 				CSharedServer(std::string& So, std::string& Path) : SoPathName(So), RegistryPath(PathName(std::move(Path))) { DOM_CALL_TRACE(""); }
 
 				virtual ~CSharedServer() { DOM_CALL_TRACE(""); }
@@ -267,7 +1055,7 @@ namespace Dom {
 						return true;
 					}
 #ifdef DEBUG
-					fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%ls`\n", iid.c_str(), "CSharedServer", __PRETTY_FUNCTION__, __LINE__);
+					fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%d`\n", iid.c_str(), "CSharedServer", __PRETTY_FUNCTION__, __LINE__);
 #endif // DEBUG
 					return false;
 				}
@@ -278,6 +1066,7 @@ namespace Dom {
 					this->QueryInterface(IUnknown::guid(), (void**)&registry);
 					if (so.RegisterServer(registry, std::move(Scope))) {
 						so.InstallServer(registry);
+						if (auto descriptor = so.Descriptor()) RegistryIndex::StoreDescription(RegistryPath, SoPathName, RegistryIndex::Description(*descriptor));
 						return true;
 					}
 					return false;
@@ -290,6 +1079,11 @@ namespace Dom {
 					return so.UnRegisterServer(registry, std::move(Scope));
 				}
 				inline virtual bool RegisterClass(const clsuid& uid, std::string&& Scope) {
+					if (!registry) {
+						registry.reset(new ClassTable());
+						ScanRegistry(RegistryPath, *registry, LoadMode::Lazy);
+					}
+					if (!registry->Insert(uid, Scope, SoPathName, LoadMode::Lazy)) return false;
 					auto ScopePath = PathName(std::move(RegistryPath), std::move(Scope));
 					if (MakeDir(ScopePath) == 0 && symlink(SoPathName.c_str(), std::string(ScopePath + uid.c_str()).c_str()) == 0) {
 						return true;
@@ -303,7 +1097,11 @@ namespace Dom {
 				}
 				inline virtual bool UnRegisterClass(const clsuid& uid, std::string&& Scope) {
 					auto ScopePath = PathName(std::move(RegistryPath), std::move(Scope));
-					return remove(std::string(ScopePath + uid.c_str()).c_str()) == 0;
+					if (remove(std::string(ScopePath + uid.c_str()).c_str()) == 0) {
+						Removed.emplace_front(uid, Scope);
+						return true;
+					}
+					return false;
 				}
 				inline virtual bool ClassExist(const clsuid& uid, std::string&& Scope) {
 					auto ScopePath = PathName(std::move(RegistryPath), std::move(Scope));
@@ -311,13 +1109,74 @@ namespace Dom {
 				}
 			};
 
+			/* Records the classes a server registers without touching the registry, so bulk calls can commit them together */
+			class CCollectServer : virtual public IUnknown, public IRegistry {
+			public:
+				std::vector<std::pair<clsuid, std::string>> Classes;
+				/* Descriptor text of the server, empty if it has none */
+				std::string Description;
+
+				CCollectServer() { DOM_CALL_TRACE(""); }
+				virtual ~CCollectServer() { DOM_CALL_TRACE(""); }
+
+				inline operator IUnknown*() { return static_cast<IUnknown*>(this); }
+
+				inline virtual long AddRef() { return 1; }
+				inline virtual long Release() { return 1; }
+
+				inline virtual bool QueryInterface(const uiid& iid, void **ppv) {
+					if (IUnknown::guid() == iid) {
+						*ppv = static_cast<IUnknown*>(this);
+						return true;
+					}
+					else if (IRegistry::guid() == iid) {
+						*ppv = static_cast<IRegistry*>(this);
+						return true;
+					}
+#ifdef DEBUG
+					fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%d`\n", iid.c_str(), "CCollectServer", __PRETTY_FUNCTION__, __LINE__);
+#endif // DEBUG
+					return false;
+				}
+
+				/* Opens `So`, lets it register and install against this collector, then closes it unless `Keep` */
+				inline bool Collect(const std::string& So, const std::string& Scope, std::string& Error, std::shared_ptr<Dll>* Keep = nullptr) {
+					try {
+						auto so = std::make_shared<Dll>(So);
+						if (!so->RegisterServer(*this, std::string(Scope))) { Error = "DllRegisterServer failed"; return false; }
+						so->InstallServer(*this);
+						if (auto descriptor = so->Descriptor()) Description = RegistryIndex::Description(*descriptor);
+						if (Keep != nullptr) *Keep = so;
+						return true;
+					}
+					catch (std::exception& ex) {
+						Error = ex.what();
+					}
+					return false;
+				}
+
+				/* Interned copy: the id of a server class points into the module, which may be closed before the commit */
+				inline virtual bool RegisterClass(const clsuid& uid, std::string&& Scope) {
+					Classes.emplace_back(clsuid(std::string(uid.c_str(), uid.length())), Scope);
+					return true;
+				}
+				inline virtual bool UnRegisterClass(const clsuid& uid, std::string&& Scope) {
+					auto&& it = std::find_if(Classes.begin(), Classes.end(), [&](const std::pair<clsuid, std::string>& cls) { return cls.first == uid && cls.second == Scope; });
+					if (it == Classes.end()) return false;
+					Classes.erase(it);
+					return true;
+				}
+				inline virtual bool ClassExist(const clsuid& uid, std::string&& Scope) {
+					return std::any_of(Classes.begin(), Classes.end(), [&](const std::pair<clsuid, std::string>& cls) { return cls.first == uid && cls.second == Scope; });
+				}
+			};
+
 			class CEmbedServer : virtual public IUnknown, public IRegistry {
 				std::string SoPathName;
-				std::unordered_multimap<clsuid, std::pair<std::string, std::string>,GUID::Hash, GUID::Equal>&	listClasses;
-				std::unordered_map<std::string, Dll>&								listServers;
+				ClassTable&	table;
 			public:
-				CEmbedServer(std::string& So, std::string& Scope, std::unordered_multimap<clsuid, std::pair<std::string, std::string>,GUID::Hash, GUID::Equal>& classes, std::unordered_map<std::string, Dll>& servers)
-					: SoPathName(So), listClasses(classes), listServers(servers) {
+				CEmbedServer(std::string& So, std::string& Scope, ClassTable& classes)
+					: SoPathName(So), table(classes) {
 					Dll so(So);
 					IUnknown* registry;
 					this->QueryInterface(IUnknown::guid(), (void**)&registry);
@@ -344,89 +1203,98 @@ namespace Dom {
 						return true;
 					}
 #ifdef DEBUG
-					fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%ls`\n", iid.c_str(), "CEmbedServer", __PRETTY_FUNCTION__, __LINE__);
+					fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%d`\n", iid.c_str(), "CEmbedServer", __PRETTY_FUNCTION__, __LINE__);
 #endif // DEBUG
 					return false;
 				}
 
 				inline virtual bool RegisterClass(const clsuid& uid, std::string&& Scope) {
-					listClasses.emplace(uid, std::make_pair(Scope, SoPathName));
-					listServers.emplace(SoPathName, Dll(SoPathName));
-					return true;
+					return table.Insert(uid, Scope, SoPathName);
 				}
 				inline virtual bool UnRegisterClass(const clsuid& uid, std::string&& Scope) {
-					auto&& range = listClasses.equal_range(uid);
-					for (auto&& it = range.first; it != range.second; it++) {
-						if (it->second.first == Scope) {
-							listClasses.erase(it);
-							return true;
-						}
-					}
-					return false;
+					return table.Unbind(uid, Scope);
 				}
 				inline virtual bool ClassExist(const clsuid& uid, std::string&& Scope) {
-					auto&& range = listClasses.equal_range(uid);
-					for (auto&& it = range.first; it != range.second; it++) {
-						if (it->second.first == Scope) {
-							return true;
-						}
-					}
-					return false;
+					return table.Find(uid, ScopeId::Lookup(Scope)) != nullptr;
 				}
 			};
 
 		public:
-			Manager() { DOM_CALL_TRACE(""); }
-			virtual ~Manager() { DOM_CALL_TRACE(""); }
+			Manager() : statistics(Statistics::Default), listTable(Linked(this)), watchStop(false), scopeFallback(false), sweeperStop(false), allocator(nullptr) {
+				DOM_CALL_TRACE("");
+				for (auto&& it : listTable.Peek()->listServers) { it.second->Initialize(*this); }
+			}
+			virtual ~Manager() {
+				DOM_CALL_TRACE("");
+				StopSweeper(); workersPool.reset(); UnwatchRegistry();
+				/* Servers may outlive the manager in ClassFactory handles, they must not reload against it */
+				std::vector<std::shared_ptr<ClassBinding>> classes;
+				std::vector<std::pair<std::string, std::shared_ptr<Dll>>> servers;
+				listTable.Peek()->Collect(classes, servers);
+				for (auto&& it : servers) { it.second->Host(nullptr); }
+				delete listTable.Peek();
+			}
 
 			inline operator IUnknown*() { return static_cast<IUnknown*>(this); }
 
 			inline virtual long AddRef() { DOM_CALL_TRACE(""); return 1; }
 			inline virtual long Release() { DOM_CALL_TRACE(""); return 1; }
+			/* IStatistics depends on this manager's state and IAllocator is not a part of it: never cached */
 			inline virtual bool QueryInterface(const uiid& iid, void **ppv) {
-				const cast_interface guids[] = { cast_interface(IFACES::guid(),(IFACES*)this)...,cast_interface(IUnknown::guid(),(IUnknown*)this) };
-				*ppv = nullptr;
-				for (auto&& it : guids) {
-					if (it.cast(iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
+				if (iid == QueryCache::Uncached) {
+					*ppv = static_cast<IUnknown*>(this);
+					return true;
+				}
+				if (iid == IStatistics::guid()) {
+					*ppv = statistics.Enabled() ? static_cast<IStatistics*>(this) : nullptr;
+					return *ppv != nullptr;
 				}
-				DOM_ERR("Interface `uiid(%s)` for `uiid(%s)` not implemented", iid.c_str(), std::remove_reference<decltype(*this)>::type::guid().c_str());
+				if (iid == IAllocator::guid()) {
+					*ppv = allocator.load(std::memory_order_acquire);
+					return *ppv != nullptr;
+				}
+				if (InterfaceTable<Manager, IFACES...>::Query(this, iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
+				DOM_ERR("Interface `uiid(%s)` for `uiid(%s)` not implemented", iid.c_str(), "Manager");
 				return false;
 			}
 
-			inline bool LoadRegistry(std::string RegistryPath = std::string(DOM_REGPATH)) { 
-				std::unique_lock<std::mutex> lock(listLock);
-				EnumFiles(RegistryPath, [&](const std::string& fullpath, const dirent& e) {
-					if (e.d_type & DT_LNK) {
-						auto ScopeName = fullpath.substr(RegistryPath.length());
-						std::string Scope;
-						if (size_t pos = ScopeName.rfind('/') != std::string::npos) {
-							Scope = ScopeName.substr(pos);
+			/* Lazy only records the class metadata, servers are opened by the first CreateInstance of one of their classes */
+			inline bool LoadRegistry(std::string RegistryPath = std::string(DOM_REGPATH), LoadMode Mode = LoadMode::Eager) { 
+				RegistryPath = PathName(std::move(RegistryPath));
+				if (auto index = OpenIndex(RegistryPath)) {
+					return Update([&](ClassTable& table) {
+						table.AttachIndex(RegistryPath, index);
+						if (Mode == LoadMode::Eager) {
+							for (auto&& cls : *index) {
+								table.Insert(clsuid(std::string(index->Value(cls.name))), std::string(index->Value(cls.scope)), std::string(index->Value(cls.so)), Mode);
+							}
 						}
-						listClasses.emplace(e.d_name, std::make_pair(Scope, fullpath));
-						listServers.emplace(fullpath,Dll(fullpath));
-					}
-				});
-				return true;
+						return true;
+					});
+				}
+				return Update([&](ClassTable& table) { ScanRegistry(RegistryPath, table, Mode); return true; });
 			}
 			
+			/* Lock-free: the lookup runs against the current snapshot, the server is called holding only the binding, so a slow
+			   constructor never holds back a writer waiting for readers to drain */
 			inline virtual bool CreateInstance(const clsuid& cid, void ** ppv, std::string Scope = std::string()) {
 				*ppv = nullptr;
-				std::unique_lock<std::mutex> lock(listLock);
 				try {
+					auto start = statistics.Start();
 					auto clsId = Dom::ClsId(cid.c_str());
-					auto&& clsEntries = listClasses.equal_range(clsId);
-					for (auto&& clsEntry = clsEntries.first; clsEntry != clsEntries.second;clsEntry++) {
-						if (clsEntry->second.first == Scope) {
-							auto&& clsDll = listServers.find(clsEntry->second.second);
-							if (clsDll == listServers.end()) {
-								DOM_ERR("Shared object `%s` for Class `%s/%s` not found in registry", clsEntry->second.second.c_str(), Scope.c_str(), cid.c_str());
-								return false;
-							}
-							DOM_CALL_TRACE("%s/%s", Scope.c_str(), cid.c_str());
-							return clsDll->second.CreateInstance(clsId, ppv);
-						}
+					ScopeId pending;
+					std::shared_ptr<const ClassBinding> clsEntry;
+					{
+						auto table = listTable.Read();
+						clsEntry = Resolve(*table, clsId, Scope, pending);
+					}
+					if (clsEntry == nullptr && pending) clsEntry = Materialize(clsId, pending.str());
+					if (clsEntry != nullptr) {
+						DOM_CALL_TRACE("%s/%s", Scope.c_str(), cid.c_str());
+						return Created(clsEntry.get(), clsEntry->CreateInstance(ppv), start);
 					}
 					DOM_ERR("Class `%s/%s` not found in registry", Scope.c_str(), cid.c_str());
+					statistics.NotFound();
 				}
 				catch (std::exception ex) {
 					DOM_ERR("Exception `%s`", ex.what());
@@ -435,11 +1303,92 @@ namespace Dom {
 				return false;
 			}
 			
+			/* Fan-out creation: one lookup and, with DllCreateInstanceBatch, one call into the server for all `count` objects.
+			   Returns how many leading entries of `ppv` hold an AddRef'd IUnknown, the rest are nullptr */
+			inline virtual size_t CreateInstances(const clsuid& cid, size_t count, void ** ppv, std::string Scope = std::string()) {
+				std::fill(ppv, ppv + count, nullptr);
+				try {
+					auto start = statistics.Start();
+					auto clsId = Dom::ClsId(cid.c_str());
+					auto Batch = [&](const ClassBinding* clsEntry) {
+						DOM_CALL_TRACE("%s/%s (%zu)", Scope.c_str(), cid.c_str(), count);
+						auto created = clsEntry->CreateInstances(count, ppv);
+						clsEntry->Count(created, count - created, start != 0);
+						statistics.Created(start);
+						return created;
+					};
+					ScopeId pending;
+					std::shared_ptr<const ClassBinding> clsEntry;
+					{
+						auto table = listTable.Read();
+						clsEntry = Resolve(*table, clsId, Scope, pending);
+					}
+					if (clsEntry == nullptr && pending) clsEntry = Materialize(clsId, pending.str());
+					if (clsEntry != nullptr) {
+						return Batch(clsEntry.get());
+					}
+					DOM_ERR("Class `%s/%s` not found in registry", Scope.c_str(), cid.c_str());
+					statistics.NotFound();
+				}
+				catch (const std::exception& ex) {
+					DOM_ERR("Exception `%s`", ex.what());
+					throw;
+				}
+				return 0;
+			}
+
+			/* Completes inline when the class is bound to an open server; otherwise the lookup, dlopen and creation run on the
+			   worker pool so the caller never blocks on a server load */
+			inline AsyncInstance CreateInstanceAsync(const clsuid& cid, std::string Scope = std::string()) {
+				auto start = statistics.Start();
+				auto clsId = Dom::ClsId(cid.c_str());
+				{
+					ScopeId pending;
+					std::shared_ptr<const ClassBinding> clsEntry;
+					{
+						auto table = listTable.Read();
+						clsEntry = Resolve(*table, clsId, Scope, pending);
+					}
+					if (clsEntry != nullptr && clsEntry->Server->IsLoaded()) {
+						DOM_CALL_TRACE("%s/%s", Scope.c_str(), cid.c_str());
+						void* ppv = nullptr;
+						try { Created(clsEntry.get(), clsEntry->CreateInstance(&ppv), start); }
+						catch (...) { return AsyncInstance(nullptr, std::current_exception()); }
+						return AsyncInstance((IUnknown*)ppv);
+					}
+					if (clsEntry == nullptr && !pending) {
+						DOM_ERR("Class `%s/%s` not found in registry", Scope.c_str(), cid.c_str());
+						statistics.NotFound();
+						return AsyncInstance(nullptr);
+					}
+				}
+				AsyncInstance result;
+				Workers().Submit([this, cid, Scope, result]() mutable {
+					void* ppv = nullptr;
+					try { CreateInstance(cid, &ppv, Scope); }
+					catch (...) { result.Complete(nullptr, std::current_exception()); return; }
+					result.Complete((IUnknown*)ppv);
+				});
+				return result;
+			}
+			/* Callback form: `done` receives the AddRef'd IUnknown (or nullptr) and the load error, if any */
+			inline void CreateInstanceAsync(const clsuid& cid, std::function<void(IUnknown*, std::exception_ptr)> done, std::string Scope = std::string()) {
+				auto result = CreateInstanceAsync(cid, std::move(Scope));
+				result.Then([result, done]() mutable {
+					IUnknown* object = nullptr;
+					std::exception_ptr error;
+					try { object = result.Get(); }
+					catch (...) { error = std::current_exception(); }
+					done(object, error);
+				});
+			}
+
 			inline virtual bool EmplaceServer(std::string SoServer, std::string Scope = std::string()) { 
 				try {
-					std::unique_lock<std::mutex> lock(listLock);
-					CEmbedServer server(SoServer, Scope, listClasses,listServers);
-					return true;
+					return Update([&](ClassTable& table) {
+						CEmbedServer server(SoServer, Scope, table);
+						return true;
+					});
 				}
 				catch (std::exception ex) {
 					DOM_ERR("Exception `%s`", ex.what());
@@ -448,22 +1397,182 @@ namespace Dom {
 				return false;
 			}
 			
+			/* Runs `SoServer` in a child host process: a crash or a stall of the server no longer takes the client down, calls on
+			   its objects fail with std::system_error instead. `Host` is an executable that calls Remote::Serve first thing in main,
+			   by default this one. Objects of its classes are proxies, Manager::CreateInstance and Interface<T> work unchanged
+			   for every interface with a registered DOM_REMOTE_PROXY; the host keeps running while a proxy or a binding holds it */
+			inline bool EmplaceRemoteServer(std::string SoServer, std::string Scope = std::string(), std::string Host = std::string("/proc/self/exe")) {
+				try {
+					auto so = RealPath(SoServer);
+					auto channel = Remote::Channel::Spawn(Host, so);
+					auto classes = channel->Classes();
+					return Update([&](ClassTable& table) {
+						for (auto&& name : classes) {
+							table.Insert(clsuid(name), Scope, "remote:" + so, channel);
+						}
+						return true;
+					});
+				}
+				catch (const std::exception& ex) {
+					DOM_ERR("Exception `%s`", ex.what());
+					throw;
+				}
+				return false;
+			}
+			
+			/* Hierarchical scope resolution: a class missing in `tenant/a/b` is looked up in `tenant/a`, `tenant`, then the global scope */
+			inline void EnableScopeFallback(bool Enable = true) { scopeFallback = Enable; }
+
+			/* One sweep pass: open servers without a call for `Idle`, no live object and no outstanding ClassFactory are finalized
+			   and closed once a previous pass found them so too. They stay registered and reopen on the next call. Returns how
+			   many were closed. The time between passes is the grace a thread gets to return from the final Release of a server
+			   object: server objects must not be released concurrently with passes run back to back */
+			inline size_t SweepIdleServers(std::chrono::nanoseconds Idle = std::chrono::seconds(1)) {
+				std::unique_lock<std::mutex> lock(sweepLock);
+				std::vector<std::shared_ptr<ClassBinding>> classes;
+				std::vector<std::pair<std::string, std::shared_ptr<Dll>>> servers;
+				listTable.Read()->Collect(classes, servers);
+				size_t swept = 0;
+				auto now = Statistics::Now();
+				for (auto&& so : servers) {
+					uint64_t reclaimed = 0;
+					if (so.second->Idle(now, (uint64_t)Idle.count()) && so.second->Sweep(*this, reclaimed)) swept++;
+				}
+				return swept;
+			}
+
+			/* Opt-in background sweeper: a pass every `Interval`, a server is closed once idle for `Idle` (the hysteresis
+			   against closing a server between two bursts of calls) */
+			inline void StartSweeper(std::chrono::nanoseconds Idle, std::chrono::nanoseconds Interval = std::chrono::seconds(1)) {
+				StopSweeper();
+				std::unique_lock<std::mutex> lock(sweeperLock);
+				sweeperStop = false;
+				sweeperThread = std::thread([this, Idle, Interval]() {
+					std::unique_lock<std::mutex> lock(sweeperLock);
+					while (!sweeperWake.wait_for(lock, Interval, [this]() { return sweeperStop; })) {
+						lock.unlock();
+						SweepIdleServers(Idle);
+						lock.lock();
+					}
+				});
+			}
+			inline void StopSweeper() {
+				{
+					std::unique_lock<std::mutex> lock(sweeperLock);
+					if (!sweeperThread.joinable()) return;
+					sweeperStop = true;
+				}
+				sweeperWake.notify_all();
+				sweeperThread.join();
+			}
+
+			/* Offers `Allocator` to servers through DllInitialize, the default one follows RequestArena::Scope of the calling thread.
+			   A server adopts it only before its first object: enable it before servers are opened */
+			inline void EnableAllocator(IAllocator* Allocator = &ArenaAllocator::Instance()) {
+				allocator = Allocator;
+				if (Allocator == nullptr) return;
+				std::vector<std::shared_ptr<ClassBinding>> classes;
+				std::vector<std::pair<std::string, std::shared_ptr<Dll>>> servers;
+				listTable.Read()->Collect(classes, servers);
+				for (auto&& so : servers) {
+					if (so.second->IsLoaded()) so.second->Initialize(*this);
+				}
+			}
+
+			/* IStatistics is only handed out by QueryInterface while enabled; DOM_STATISTICS enables it from construction */
+			inline void EnableStatistics(bool Enable = true) {
+				statistics.Enable(Enable);
+			}
+
+			inline virtual bool GetStatistics(IStatistics::Snapshot& Snapshot) {
+				if (!statistics.Enabled()) return false;
+				statistics.Fill(Snapshot);
+				Snapshot.Classes.clear(); Snapshot.Scopes.clear(); Snapshot.Servers.clear();
+				std::map<std::string, IStatistics::Scope> scopes;
+				/* Servers are asked for their live objects once the snapshot is let go */
+				std::vector<std::shared_ptr<ClassBinding>> classes;
+				std::vector<std::pair<std::string, std::shared_ptr<Dll>>> servers;
+				listTable.Read()->Collect(classes, servers);
+				for (auto&& it : classes) {
+					auto&& cls = *it;
+					auto name = std::string(cls.ClsId.c_str(), cls.ClsId.length());
+					IStatistics::Class counters = { name.compare(0, sizeof(dom_cls_pre_name) - 1, dom_cls_pre_name) == 0 ? name.substr(sizeof(dom_cls_pre_name) - 1) : name, cls.Scope, 0, 0, cls.Server->InstanceCount(cls.ClsId) };
+					if (auto sharded = cls.Counters.load(std::memory_order_acquire)) {
+						sharded->ForEach([&](const ClassCounters& local) {
+							counters.Creates += local.Creates.load(std::memory_order_relaxed);
+							counters.Failures += local.Failures.load(std::memory_order_relaxed);
+						});
+					}
+					auto&& scope = scopes.emplace(cls.Scope, IStatistics::Scope{ cls.Scope, 0, 0 }).first->second;
+					scope.Creates += counters.Creates;
+					scope.Failures += counters.Failures;
+					Snapshot.Classes.push_back(std::move(counters));
+				}
+				for (auto&& it : scopes) { Snapshot.Scopes.push_back(it.second); }
+				for (auto&& it : servers) {
+					Snapshot.Servers.push_back({ it.first, it.second->IsLoaded(), it.second->LoadNanos(), it.second->Loads(), it.second->Unloads(), it.second->ReclaimedBytes() });
+				}
+				return true;
+			}
+
 			inline virtual ClassList EnumClasses(std::string Scope = std::string()) { 
 				ClassList list;
-				std::unique_lock<std::mutex> lock(listLock);
-				for (auto&& co : listClasses) {
-					if (Scope.empty() || Scope == co.second.first) {
-						list.emplace_after(list.end(), std::make_pair(co.first, co.second.first));
+				auto table = listTable.Read();
+				for (auto&& co : table->listClasses) {
+					if (Scope.empty() || Scope == co.second->Scope) {
+						list.emplace_front(co.first, co.second->Scope);
+					}
+				}
+				for (auto&& indexed : table->listIndexes) {
+					auto&& index = indexed.second->Index();
+					for (auto&& cls : index) {
+						std::string ClassScope(index.Value(cls.scope));
+						clsuid cid(std::string(index.Value(cls.name)));
+						if ((Scope.empty() || Scope == ClassScope) && table->Find(cid, ScopeId::Lookup(ClassScope)) == nullptr) {
+							list.emplace_front(cid, ClassScope);
+						}
 					}
 				}
 				return list;
 			}
 
+			/* Typed creation: the server hands out IUnknown, the requested interface is queried from it */
+			template<typename T>
+			inline bool CreateInstance(const clsuid& cid, Interface<T>& object, std::string Scope = std::string()) {
+				IUnknown* unkn;
+				object.Release();
+				if (CreateInstance(cid, (void**)&unkn, std::move(Scope))) {
+					object.Attach(unkn);
+				}
+				return (bool)object;
+			}
+
+			/* Resolve (class, scope) once; the handle creates instances without lookups, hashing or locks */
+			inline ClassFactory ResolveClass(const clsuid& cid, std::string Scope = std::string()) {
+				auto clsId = Dom::ClsId(cid.c_str());
+				std::shared_ptr<ClassBinding> binding;
+				ScopeId pending;
+				{
+					auto table = listTable.Read();
+					binding = std::const_pointer_cast<ClassBinding>(Resolve(*table, clsId, Scope, pending));
+				}
+				if (binding || (pending && (binding = Materialize(clsId, pending.str())))) {
+					return ClassFactory(binding);
+				}
+				DOM_ERR("Class `%s/%s` not found in registry", Scope.c_str(), cid.c_str());
+				return ClassFactory();
+			}
+
 			inline virtual bool RegisterServer(std::string SoServer, std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
 				try {
-					std::unique_lock<std::mutex> lock(listLock);
+					TimedLock lock(listLock, statistics);
 					CSharedServer server(SoServer, RegistryPath);
-					return server.Register(Scope);
+					if (server.Register(Scope)) {
+						lock.unlock();
+						RefreshIndex(PathName(std::move(RegistryPath)));
+						return true;
+					}
+					return false;
 				}
 				catch (std::exception ex) {
 					DOM_ERR("Exception `%s`", ex.what());
@@ -471,11 +1580,92 @@ namespace Dom {
 				}
 				return false;
 			}
+			/* Bulk RegisterServer: servers are opened and queried concurrently on the worker pool, then every scope directory is
+			   created once and all links are made in one critical section. The registry index is rebuilt once at the end */
+			inline virtual ServerReports RegisterServers(const std::vector<std::string>& SoServers, std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
+				std::vector<std::pair<std::string, std::string>> servers;
+				for (auto&& so : SoServers) servers.emplace_back(so, Scope);
+				return RegisterServers(servers, std::move(RegistryPath));
+			}
+			/* (server, scope) pairs, e.g. one scope per plugin */
+			inline virtual ServerReports RegisterServers(const std::vector<std::pair<std::string, std::string>>& SoServers, std::string RegistryPath = std::string(DOM_REGPATH)) {
+				RegistryPath = PathName(std::move(RegistryPath));
+				ServerReports reports(SoServers.size());
+				std::vector<CCollectServer> servers(SoServers.size());
+				Workers().ForEach(SoServers.size(), [&](size_t n) {
+					reports[n].SoServer = SoServers[n].first;
+					reports[n].Succeeded = servers[n].Collect(SoServers[n].first, SoServers[n].second, reports[n].Error);
+				});
+				{
+					TimedLock lock(listLock, statistics);
+					std::map<std::string, int> scopes;
+					ClassTable registry;
+					ScanRegistry(RegistryPath, registry, LoadMode::Lazy);
+					for (size_t n = 0; n < servers.size(); n++) {
+						if (!reports[n].Succeeded) continue;
+						for (auto&& cls : servers[n].Classes) {
+							if (!registry.Insert(cls.first, cls.second, SoServers[n].first, LoadMode::Lazy)) {
+								reports[n].Succeeded = false;
+								reports[n].Error += (reports[n].Error.empty() ? "" : "; ") + std::string("class ") + cls.first.c_str() + " collides with a registered class id";
+								continue;
+							}
+							auto ScopePath = PathName(std::move(RegistryPath), std::move(cls.second));
+							auto&& made = scopes.emplace(ScopePath, 0);
+							if (made.second) made.first->second = MakeDir(ScopePath);
+							int error = made.first->second != 0 ? made.first->second : symlink(SoServers[n].first.c_str(), std::string(ScopePath + cls.first.c_str()).c_str()) == 0 ? 0 : errno;
+							if (error != 0) {
+								DOM_ERR("Class `%s` of `%s` not registered `%s`", cls.first.c_str(), SoServers[n].first.c_str(), strerror(error));
+								reports[n].Succeeded = false;
+								reports[n].Error += (reports[n].Error.empty() ? "" : "; ") + ScopePath + cls.first.c_str() + " `" + strerror(error) + "`";
+							}
+						}
+						if (!servers[n].Description.empty()) RegistryIndex::StoreDescription(RegistryPath, SoServers[n].first, servers[n].Description);
+					}
+				}
+				RefreshIndex(RegistryPath);
+				return reports;
+			}
+
+			/* Bulk EmplaceServer: servers are opened and queried concurrently, their classes are bound in a single table update */
+			inline virtual ServerReports EmplaceServers(const std::vector<std::string>& SoServers, std::string Scope = std::string()) {
+				ServerReports reports(SoServers.size());
+				std::vector<CCollectServer> servers(SoServers.size());
+				std::vector<std::shared_ptr<Dll>> loaded(SoServers.size());
+				Workers().ForEach(SoServers.size(), [&](size_t n) {
+					reports[n].SoServer = SoServers[n];
+					reports[n].Succeeded = servers[n].Collect(SoServers[n], Scope, reports[n].Error, &loaded[n]);
+				});
+				Update([&](ClassTable& table) {
+					for (size_t n = 0; n < servers.size(); n++) {
+						if (!reports[n].Succeeded) continue;
+						table.EmplaceServer(SoServers[n], loaded[n]);
+						for (auto&& cls : servers[n].Classes) {
+							if (!table.Insert(cls.first, cls.second, SoServers[n])) {
+								reports[n].Succeeded = false;
+								reports[n].Error += (reports[n].Error.empty() ? "" : "; ") + std::string("class ") + cls.first.c_str() + " collides with a registered class id";
+							}
+						}
+					}
+					return true;
+				});
+				return reports;
+			}
+
 			inline virtual bool UnRegisterServer(std::string SoServer, std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
 				try {
-					std::unique_lock<std::mutex> lock(listLock);
+					TimedLock lock(listLock, statistics);
 					CSharedServer server(SoServer, RegistryPath);
-					return server.UnRegister(Scope);
+					if (server.UnRegister(Scope)) {
+						RegistryIndex::RemoveDescription(RegistryPath, SoServer);
+						lock.unlock();
+						RefreshIndex(PathName(std::move(RegistryPath)));
+						Update([&](ClassTable& table) {
+							for (auto&& cls : server.Removed) { table.Unbind(cls.first, cls.second); }
+							return true;
+						});
+						return true;
+					}
+					return false;
 				}
 				catch (std::exception ex) {
 					DOM_ERR("Exception `%s`", ex.what());
@@ -483,18 +1673,146 @@ namespace Dom {
 				}
 				return false;
 			}
+			/* Opt-in incremental registry updates. Classes of the tree are bound lazily right away, later symlink changes are applied
+			   as deltas. Returns a descriptor to poll for readability before calling ProcessRegistryEvents(), or -1 on failure;
+			   with Background a thread does the polling */
+			inline int WatchRegistry(std::string RegistryPath = std::string(DOM_REGPATH), bool Background = false) {
+				RegistryPath = PathName(std::move(RegistryPath));
+				std::vector<RegistryWatcher::Change> changes;
+				{
+					std::unique_lock<std::mutex> lock(watchLock);
+					if (!watchRegistry) {
+						watchRegistry.reset(new RegistryWatcher());
+					}
+					if (!watchRegistry->Watch(RegistryPath, changes)) {
+						return -1;
+					}
+					if (std::find(watchRoots.begin(), watchRoots.end(), RegistryPath) == watchRoots.end()) {
+						watchRoots.push_back(RegistryPath);
+					}
+					ApplyChanges(changes);
+					if (Background && !watchThread.joinable()) {
+						watchStop = false;
+						watchThread = std::thread([this]() {
+							struct pollfd pfd = { watchRegistry->Descriptor(), POLLIN, 0 };
+							while (!watchStop) {
+								if (poll(&pfd, 1, 100) > 0) {
+									ProcessRegistryEvents();
+								}
+							}
+						});
+					}
+				}
+				return watchRegistry->Descriptor();
+			}
+
+			/* Drains pending registry events; false if nothing changed */
+			inline bool ProcessRegistryEvents() {
+				std::unique_lock<std::mutex> lock(watchLock);
+				if (!watchRegistry) return false;
+				std::vector<RegistryWatcher::Change> changes;
+				if (watchRegistry->Read(changes)) {
+					ApplyChanges(changes);
+				}
+				else {
+					DOM_ERR("Registry event queue overflow, rescanning");
+					changes.clear();
+					for (auto&& root : watchRoots) { watchRegistry->Watch(root, changes); }
+					ApplyChanges(changes, watchRoots);
+				}
+				return !changes.empty();
+			}
+
+			inline void UnwatchRegistry() {
+				watchStop = true;
+				if (watchThread.joinable()) {
+					watchThread.join();
+				}
+				std::unique_lock<std::mutex> lock(watchLock);
+				watchRegistry.reset();
+				watchRoots.clear();
+			}
+
 			inline virtual ClassList EnumServers(std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
-				std::unique_lock<std::mutex> lock(listLock);
-				auto ScopePath = PathName(std::move(RegistryPath),std::move(Scope));
+				TimedLock lock(listLock, statistics);
+				RegistryPath = PathName(std::move(RegistryPath));
 				ClassList list;
+				if (auto index = OpenIndex(RegistryPath)) {
+					for (auto&& cls : *index) {
+						auto ClassScope = index->Value(cls.scope);
+						if (Scope.empty() || ClassScope == Scope || (ClassScope.length() > Scope.length() && ClassScope.compare(0, Scope.length(), Scope) == 0 && ClassScope[Scope.length()] == '/')) {
+							list.emplace_front(std::string(index->Value(cls.name)), std::string(ClassScope));
+						}
+					}
+					return list;
+				}
+				auto ScopePath = PathName(std::move(RegistryPath),std::move(Scope));
 				EnumFiles(ScopePath, [&](const std::string& fullpath, const dirent& e) {
 					if (e.d_type & DT_LNK) {
 						auto ScopeName = fullpath.substr(RegistryPath.length());
-						list.emplace_after(list.end(), std::make_pair(e.d_name, ScopeName.substr(ScopeName.rfind('/'))));
+						size_t pos = ScopeName.rfind('/');
+						list.emplace_front(e.d_name, pos != std::string::npos ? ScopeName.substr(0, pos) : std::string());
 					}
 				});
 				return list;
 			}
+
+			/* Registered classes implementing `iid`, answered from the descriptors stored at registration: no server is opened.
+			   Classes of servers without a descriptor are never listed */
+			inline virtual ClassList EnumImplementers(const uiid& iid, std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
+				TimedLock lock(listLock, statistics);
+				ClassList list;
+				if (auto index = OpenIndex(PathName(std::move(RegistryPath)))) {
+					for (auto&& cls : *index) {
+						auto ClassScope = index->Value(cls.scope);
+						if ((Scope.empty() || ClassScope == Scope) && index->Implements(cls, iid)) {
+							list.emplace_front(std::string(index->Value(cls.name)), std::string(ClassScope));
+						}
+					}
+				}
+				return list;
+			}
+			/* Interfaces, activation and object size of a registered class, without opening its server */
+			inline virtual bool DescribeClass(const clsuid& cid, ClassDescription& Description, std::string RegistryPath = std::string(DOM_REGPATH), std::string Scope = std::string()) {
+				TimedLock lock(listLock, statistics);
+				if (auto index = OpenIndex(PathName(std::move(RegistryPath)))) {
+					if (auto cls = index->Find(Dom::ClsId(cid.c_str()), Scope)) {
+						Description = index->Describe(*cls);
+						return true;
+					}
+				}
+				return false;
+			}
 		};
 	}
+
+	namespace Remote {
+		/* Host process side of Manager::EmplaceRemoteServer. Call it first thing in main:
+			if (int rc = Dom::Remote::Serve(argc, argv); rc >= 0) return rc;
+		   Returns -1 when the process was not started as a host, otherwise serves the region until the client closes it */
+		inline int Serve(int argc, char* argv[]) {
+			if (argc < 3 || std::strcmp(argv[1], Channel::HostFlag) != 0) return -1;
+			prctl(PR_SET_PDEATHSIG, SIGKILL);
+			struct stat info;
+			void* mapped = MAP_FAILED;
+			if (fstat(3, &info) != 0 || (size_t)info.st_size != sizeof(Region) || (mapped = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, 3, 0)) == MAP_FAILED) {
+				fprintf(stderr, "Remote host `%s`: no region\n", argv[2]);
+				return 2;
+			}
+			auto&& region = *(Region*)mapped;
+			if (region.magic != Region::Magic || getppid() != region.client) return 2;
+			try {
+				Client::Manager<> manager;
+				manager.EmplaceServer(argv[2]);
+				std::vector<std::string> classes;
+				for (auto&& cls : manager.EnumClasses()) classes.emplace_back(cls.first.c_str(), cls.first.length());
+				Server server(region, std::move(classes), [&](const clsuid& cid, void** ppv) { return manager.CreateInstance(cid, ppv); });
+				return server.Run();
+			}
+			catch (std::exception& ex) {
+				fprintf(stderr, "Remote host `%s`: %s\n", argv[2], ex.what());
+				return 1;
+			}
+		}
+	}
 }
\ No newline at end of file
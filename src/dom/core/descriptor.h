@@ -0,0 +1,51 @@
+#pragma once
+#include "../IUnknown.h"
+#include <string>
+#include <cstdint>
+
+namespace Dom {
+	namespace Trace { class Tracer; }
+
+	/* Static description of a server module, returned by its DllGetServerDescriptor export: every entry point in one lookup and
+	   every class with its interfaces, known without creating an object. Any layout change bumps Version, which stays first */
+	struct ServerDescriptor {
+		static constexpr uint32_t Version = 1;
+
+		/* Activation model of a class, see Dom::Server::Activation */
+		enum Model : uint32_t { PerCall = 0, Singleton = 1, PerThread = 2, Pooled = 3 };
+		enum Flags : uint32_t { ModelMask = 0xff, PooledMemory = 0x100 };
+
+		struct Class {
+			const char*			ClsId;
+			/* IUnknown first */
+			const char* const*	Iids;
+			uint32_t			IidCount;
+			uint32_t			Flags;
+			/* Objects of a Pooled class */
+			uint32_t			Slots;
+			uint64_t			Size;
+		};
+
+		uint32_t			AbiVersion;
+		uint32_t			ClassCount;
+		const Class*		Classes;
+
+		/* The functions behind the Dll* exports */
+		bool(*CreateInstance)(const clsuid&, void**);
+		size_t(*CreateInstanceBatch)(const clsuid&, size_t, void**);
+		bool(*CanUnloadNow)();
+		long(*InstanceCount)(const clsuid&);
+		bool(*RegisterServer)(IUnknown*, std::string&&);
+		bool(*UnRegisterServer)(IUnknown*, std::string&&);
+		bool(*InstallServer)(IUnknown*);
+		bool(*UnInstallServer)(IUnknown*);
+		bool(*Initialize)(IUnknown*);
+		bool(*Finalize)(IUnknown*);
+		void(*AttachTrace)(Trace::Tracer*);
+
+		inline const Class* Find(const clsuid& cid) const {
+			for (auto cls = Classes; cls != Classes + ClassCount; cls++) { if (GuidHash(cls->ClsId, GuidLength(cls->ClsId)) == cid.hash()) return cls; }
+			return nullptr;
+		}
+	};
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include "../guid.h"
+#include "descriptor.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+
+namespace Dom {
+	namespace Client {
+
+		/* What the registry knows of a class without opening its server; Interfaces is empty if the server has no descriptor */
+		struct ClassDescription {
+			std::string					ClsId, Scope, SoServer;
+			std::vector<std::string>	Interfaces;
+			uint32_t					Flags = 0, Slots = 0;
+			uint64_t					Size = 0;
+		};
+
+		/* Versioned binary image of a registry tree, kept next to it as `<registry>.index` and queried in place through mmap.
+		   Every directory of the tree is stamped with its mtime, so a registration made behind our back makes the index stale */
+		class RegistryIndex {
+		public:
+			static constexpr uint32_t Version = 2;
+
+			struct Text {
+				uint32_t	offset;
+				uint32_t	length;
+			};
+			struct Header {
+				char		magic[8];
+				uint32_t	version;
+				uint32_t	dirs;
+				uint32_t	classes;
+				uint32_t	reserved;
+				uint64_t	strings;
+				uint64_t	size;
+			};
+			struct Dir {
+				Text		path;
+				int64_t		sec;
+				int64_t		nsec;
+			};
+			/* Sorted by class id hash, then scope. The rest comes from the server descriptor, iids are space separated */
+			struct Class {
+				uint64_t	cid;
+				Text		name;
+				Text		scope;
+				Text		so;
+				Text		iids;
+				uint32_t	flags;
+				uint32_t	slots;
+				uint64_t	size;
+			};
+		private:
+			static constexpr char Magic[8] = { 'D','O','M','I','N','D','E','X' };
+
+			void*			image;
+			size_t			size;
+			const Header*	header;
+			const Dir*		dirs;
+			const Class*	classes;
+			const char*		strings;
+			/* mtime of the index file, written after the walk */
+			int64_t			written_sec, written_nsec;
+
+			static inline std::string Root(const std::string& RegistryPath) { return RegistryPath.back() == '/' ? RegistryPath : RegistryPath + '/'; }
+			static inline bool Stamp(const std::string& path, int64_t& sec, int64_t& nsec) {
+				struct stat info;
+				if (stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) return false;
+				sec = info.st_mtim.tv_sec; nsec = info.st_mtim.tv_nsec;
+				return true;
+			}
+			static inline std::string DescriptionName(const std::string& RegistryPath, const std::string& so) {
+				char name[24];
+				snprintf(name, sizeof(name), "%016llx", (unsigned long long)GuidHash(so.data(), so.length()));
+				return Root(RegistryPath) + ".servers/" + name;
+			}
+			static inline bool ReadFile(const std::string& path, std::string& text) {
+				auto file = fopen(path.c_str(), "rb");
+				if (file == nullptr) return false;
+				char block[4096];
+				for (size_t n; (n = fread(block, 1, sizeof(block), file)) > 0;) text.append(block, n);
+				fclose(file);
+				return true;
+			}
+			/* Class lines of a stored description: id, flags, slots, size and iids, tab separated */
+			struct Stored {
+				uint32_t	flags, slots;
+				uint64_t	size;
+				std::string	iids;
+			};
+			static inline std::map<std::string, Stored> LoadDescription(const std::string& RegistryPath, const std::string& so) {
+				std::map<std::string, Stored> classes;
+				std::string text;
+				if (!ReadFile(DescriptionName(RegistryPath, so), text)) return classes;
+				size_t at = text.find('\n');
+				if (at == std::string::npos || text.compare(0, at, so) != 0) return classes;
+				for (size_t end; ++at < text.length(); at = end) {
+					if ((end = text.find('\n', at)) == std::string::npos) end = text.length();
+					std::string line(text, at, end - at);
+					size_t tabs[4], n = 0;
+					for (size_t pos = 0; n < 4 && (pos = line.find('\t', pos)) != std::string::npos; pos++) tabs[n++] = pos;
+					if (n < 4) continue;
+					classes[line.substr(0, tabs[0])] = { (uint32_t)strtoul(line.c_str() + tabs[0] + 1, nullptr, 10), (uint32_t)strtoul(line.c_str() + tabs[1] + 1, nullptr, 10),
+						strtoull(line.c_str() + tabs[2] + 1, nullptr, 10), line.substr(tabs[3] + 1) };
+				}
+				return classes;
+			}
+		public:
+			static inline std::string FileName(const std::string& RegistryPath) {
+				auto name = RegistryPath;
+				while (name.length() > 1 && name.back() == '/') name.pop_back();
+				return name + ".index";
+			}
+
+			RegistryIndex(const std::string& RegistryPath) : image(nullptr), size(0), header(nullptr), dirs(nullptr), classes(nullptr), strings(nullptr), written_sec(0), written_nsec(0) {
+				int fd = open(FileName(RegistryPath).c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0) return;
+				struct stat info;
+				if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(Header)) {
+					size = (size_t)info.st_size;
+					written_sec = info.st_mtim.tv_sec; written_nsec = info.st_mtim.tv_nsec;
+					image = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+					if (image == MAP_FAILED) { image = nullptr; size = 0; }
+				}
+				close(fd);
+				if (image == nullptr) return;
+
+				auto h = (const Header*)image;
+				if (std::memcmp(h->magic, Magic, sizeof(Magic)) != 0 || h->version != Version || h->size != size ||
+					sizeof(Header) + h->dirs * sizeof(Dir) + h->classes * sizeof(Class) != h->strings || h->strings > size) {
+					DOM_ERR("Registry index `%s` is corrupt or of another version", FileName(RegistryPath).c_str());
+					return;
+				}
+				header = h;
+				dirs = (const Dir*)(h + 1);
+				classes = (const Class*)(dirs + h->dirs);
+				strings = (const char*)image + h->strings;
+			}
+			RegistryIndex(const RegistryIndex&) = delete;
+			~RegistryIndex() { if (image != nullptr) munmap(image, size); }
+
+			inline bool Valid() const { return header != nullptr; }
+
+			/* One stat per directory instead of a full readdir walk. A directory stamped no earlier than the index file was written
+			   is racy: a link added after its readdir, within the same timestamp tick, leaves its mtime unchanged. Such an index is
+			   not fresh, the rebuild it takes a tick later is */
+			inline bool Fresh(const std::string& RegistryPath) const {
+				if (!Valid()) return false;
+				auto root = Root(RegistryPath);
+				for (auto dir = dirs; dir != dirs + header->dirs; dir++) {
+					int64_t sec, nsec;
+					if (!Stamp(root + std::string(Value(dir->path)), sec, nsec) || sec != dir->sec || nsec != dir->nsec) return false;
+					if (sec > written_sec || (sec == written_sec && nsec >= written_nsec)) return false;
+				}
+				return true;
+			}
+
+			inline std::string_view Value(const Text& text) const {
+				return text.offset + (uint64_t)text.length <= size - header->strings ? std::string_view(strings + text.offset, text.length) : std::string_view();
+			}
+			/* False for classes of servers registered without a descriptor: nothing is known about their interfaces */
+			inline bool Described(const Class& cls) const { return cls.iids.length != 0; }
+			inline bool Implements(const Class& cls, const uiid& iid) const {
+				auto iids = Value(cls.iids);
+				for (size_t at = 0, end; at < iids.length(); at = end + 1) {
+					if ((end = iids.find(' ', at)) == std::string_view::npos) end = iids.length();
+					if (GuidHash(iids.data() + at, end - at) == iid.hash()) return true;
+				}
+				return false;
+			}
+			inline ClassDescription Describe(const Class& cls) const {
+				ClassDescription description{ std::string(Value(cls.name)), std::string(Value(cls.scope)), std::string(Value(cls.so)), {}, cls.flags, cls.slots, cls.size };
+				auto iids = Value(cls.iids);
+				for (size_t at = 0, end; at < iids.length(); at = end + 1) {
+					if ((end = iids.find(' ', at)) == std::string_view::npos) end = iids.length();
+					description.Interfaces.emplace_back(iids.substr(at, end - at));
+				}
+				return description;
+			}
+
+			inline const Class* begin() const { return classes; }
+			inline const Class* end() const { return Valid() ? classes + header->classes : classes; }
+
+			inline const Class* Find(const clsuid& cid, std::string_view scope) const {
+				auto&& it = std::lower_bound(begin(), end(), (uint64_t)cid.hash(), [](const Class& c, uint64_t v) { return c.cid < v; });
+				for (; it != end() && it->cid == cid.hash(); it++) {
+					if (Value(it->scope) == scope) return it;
+				}
+				return nullptr;
+			}
+
+			/* Server descriptor text: one line per class, see LoadDescription */
+			static inline std::string Description(const ServerDescriptor& descriptor) {
+				std::string text;
+				for (auto cls = descriptor.Classes; cls != descriptor.Classes + descriptor.ClassCount; cls++) {
+					text += std::string(cls->ClsId) + '\t' + std::to_string(cls->Flags) + '\t' + std::to_string(cls->Slots) + '\t' + std::to_string(cls->Size) + '\t';
+					for (uint32_t n = 0; n < cls->IidCount; n++) { text += (n != 0 ? " " : "") + std::string(cls->Iids[n]); }
+					text += '\n';
+				}
+				return text;
+			}
+			/* Kept in `<registry>/.servers/`, one file per server path as registered, for Build to fold into the index. A file
+			   goes with the last class link to its server, see RemoveDescription */
+			static inline bool StoreDescription(const std::string& RegistryPath, const std::string& so, const std::string& description) {
+				auto dir = Root(RegistryPath) + ".servers";
+				if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+				auto name = DescriptionName(RegistryPath, so);
+				auto temp = name + '.' + std::to_string(getpid());
+				if (auto file = fopen(temp.c_str(), "wb")) {
+					bool written = fprintf(file, "%s\n", so.c_str()) > 0 && fwrite(description.data(), 1, description.length(), file) == description.length();
+					written = fclose(file) == 0 && written;
+					if (written && rename(temp.c_str(), name.c_str()) == 0) return true;
+					remove(temp.c_str());
+				}
+				DOM_ERR("Server description `%s` of `%s` not written `%s`", name.c_str(), so.c_str(), strerror(errno));
+				return false;
+			}
+
+			/* Drops the description of `so` once no class link of the registry targets it any more */
+			static inline bool RemoveDescription(const std::string& RegistryPath, const std::string& so) {
+				std::deque<std::string> queue({ Root(RegistryPath) });
+				for (; !queue.empty(); queue.pop_front()) {
+					auto handle = opendir(queue.front().c_str());
+					if (handle == nullptr) continue;
+					bool linked = false;
+					while (auto f = readdir(handle)) {
+						if (f->d_name[0] == '.') continue;
+						auto path = queue.front() + f->d_name;
+						struct stat info;
+						if (lstat(path.c_str(), &info) != 0) continue;
+						if (S_ISDIR(info.st_mode)) {
+							queue.push_back(path + '/');
+						}
+						else if (S_ISLNK(info.st_mode)) {
+							char target[PATH_MAX];
+							auto length = readlink(path.c_str(), target, sizeof(target));
+							if ((linked = length > 0 && so.compare(0, std::string::npos, target, (size_t)length) == 0)) break;
+						}
+					}
+					closedir(handle);
+					if (linked) return false;
+				}
+				return remove(DescriptionName(RegistryPath, so).c_str()) == 0;
+			}
+
+			/* Walks the tree and atomically replaces the index file */
+			static inline bool Build(const std::string& RegistryPath) {
+				struct Entry { uint64_t cid; std::string name, scope, so; Stored described; };
+				std::map<std::string, std::map<std::string, Stored>> descriptions;
+				auto Lookup = [&](const std::string& link, const char* name) {
+					char target[PATH_MAX];
+					auto length = readlink(link.c_str(), target, sizeof(target));
+					if (length <= 0 || (size_t)length >= sizeof(target)) return Stored{ 0, 0, 0, std::string() };
+					std::string so(target, (size_t)length);
+					auto&& it = descriptions.find(so);
+					if (it == descriptions.end()) it = descriptions.emplace(so, LoadDescription(RegistryPath, so)).first;
+					auto&& cls = it->second.find(name);
+					return cls != it->second.end() ? cls->second : Stored{ 0, 0, 0, std::string() };
+				};
+				auto root = Root(RegistryPath);
+				std::vector<char> text;
+				std::vector<Dir> listDirs;
+				std::vector<Entry> listEntries;
+				auto Append = [&](const std::string& value) { Text t{ (uint32_t)text.size(), (uint32_t)value.length() }; text.insert(text.end(), value.begin(), value.end()); return t; };
+
+				std::deque<std::string> queue({ std::string() });
+				for (; !queue.empty(); queue.pop_front()) {
+					auto scope = queue.front();
+					auto path = root + scope;
+					Dir dir;
+					if (!Stamp(path, dir.sec, dir.nsec)) return false;
+					dir.path = Append(scope);
+					listDirs.push_back(dir);
+
+					auto handle = opendir(path.c_str());
+					if (handle == nullptr) return false;
+					while (auto f = readdir(handle)) {
+						if (f->d_name[0] == '.') continue;
+						auto type = f->d_type;
+						if (type == DT_UNKNOWN) {
+							struct stat info;
+							type = lstat((path + f->d_name).c_str(), &info) != 0 ? DT_UNKNOWN : S_ISDIR(info.st_mode) ? DT_DIR : S_ISLNK(info.st_mode) ? DT_LNK : DT_REG;
+						}
+						if (type == DT_DIR) {
+							queue.push_back(scope + f->d_name + '/');
+						}
+						else if (type == DT_LNK) {
+							listEntries.push_back({ GuidHash(f->d_name, std::strlen(f->d_name)), f->d_name, scope.empty() ? scope : scope.substr(0, scope.length() - 1), path + f->d_name, Lookup(path + f->d_name, f->d_name) });
+						}
+					}
+					closedir(handle);
+				}
+				std::sort(listEntries.begin(), listEntries.end(), [](const Entry& l, const Entry& r) { return l.cid < r.cid || (l.cid == r.cid && l.scope < r.scope); });
+
+				std::vector<Class> listClasses;
+				for (auto&& e : listEntries) {
+					listClasses.push_back({ e.cid, Append(e.name), Append(e.scope), Append(e.so), Append(e.described.iids), e.described.flags, e.described.slots, e.described.size });
+				}
+
+				Header h;
+				std::memcpy(h.magic, Magic, sizeof(Magic));
+				h.version = Version; h.dirs = (uint32_t)listDirs.size(); h.classes = (uint32_t)listClasses.size(); h.reserved = 0;
+				h.strings = sizeof(Header) + listDirs.size() * sizeof(Dir) + listClasses.size() * sizeof(Class);
+				h.size = h.strings + text.size();
+
+				auto name = FileName(RegistryPath);
+				auto temp = name + '.' + std::to_string(getpid());
+				if (auto file = fopen(temp.c_str(), "wb")) {
+					bool written = fwrite(&h, sizeof(h), 1, file) == 1 &&
+						(listDirs.empty() || fwrite(listDirs.data(), sizeof(Dir), listDirs.size(), file) == listDirs.size()) &&
+						(listClasses.empty() || fwrite(listClasses.data(), sizeof(Class), listClasses.size(), file) == listClasses.size()) &&
+						(text.empty() || fwrite(text.data(), 1, text.size(), file) == text.size());
+					written = fclose(file) == 0 && written;
+					if (written && rename(temp.c_str(), name.c_str()) == 0) return true;
+					remove(temp.c_str());
+				}
+				DOM_ERR("Registry index `%s` not written `%s`", name.c_str(), strerror(errno));
+				return false;
+			}
+		};
+	}
+}
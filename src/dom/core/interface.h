@@ -1,26 +1,138 @@
 #pragma once
 #include "../IUnknown.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
 
 namespace Dom {
+	/* Per-type QueryInterface table: interface id -> upcast, sorted by id at compile time */
+	template <typename OWNER, typename ... IFACES>
+	class InterfaceTable {
+	public:
+		struct Entry {
+			uint64_t	iid;
+			void*		(*cast)(OWNER*);
+		};
+		static constexpr size_t Count = sizeof...(IFACES) + 1;
+		static_assert(UniqueIds({ IFACES::guid().hash()..., IUnknown::guid().hash() }), "IID hash collision between object interfaces");
+	private:
+		template<typename I>
+		static void* Cast(OWNER* self) { return static_cast<I*>(self); }
+
+		static constexpr std::array<Entry, Count> Sort(std::array<Entry, Count> table) {
+			for (size_t i = 1; i < Count; i++) {
+				for (size_t j = i; j > 0 && table[j].iid < table[j - 1].iid; j--) {
+					Entry e = table[j]; table[j] = table[j - 1]; table[j - 1] = e;
+				}
+			}
+			return table;
+		}
+	public:
+		static constexpr std::array<Entry, Count> Entries = Sort({ { { IFACES::guid().hash(), &Cast<IFACES> }..., { IUnknown::guid().hash(), &Cast<IUnknown> } } });
+
+		static inline bool Query(OWNER* self, const uiid& iid, void **ppv) {
+			const uint64_t id = iid.hash();
+			if (Count <= 8) {
+				for (auto&& it : Entries) {
+					if (it.iid >= id) {
+						if (it.iid != id) break;
+						*ppv = it.cast(self); return true;
+					}
+				}
+			}
+			else {
+				auto&& it = std::lower_bound(Entries.begin(), Entries.end(), id, [](const Entry& e, uint64_t v) { return e.iid < v; });
+				if (it != Entries.end() && it->iid == id) { *ppv = it->cast(self); return true; }
+			}
+			*ppv = nullptr;
+			return false;
+		}
+	};
+
+	/* Opt-in (DOM_QI_CACHE) per-thread (vtable, iid) -> pointer adjustment cache, misses included. Only right for objects whose
+	   QueryInterface answers with their own subobjects whatever their state; others answer the Uncached id and are never cached */
+	class QueryCache {
+		struct Entry {
+			const void*	vtbl;
+			uint64_t	iid;
+			std::ptrdiff_t	offset;
+		};
+		static constexpr size_t Size = 256;
+		static constexpr std::ptrdiff_t Miss = PTRDIFF_MIN, Bypass = PTRDIFF_MIN + 1;
+		struct Table {
+			uint64_t	epoch;
+			Entry		entries[Size];
+		};
+		static inline std::atomic<uint64_t>& Epoch() { static std::atomic<uint64_t> epoch(1); return epoch; }
+		/* Trivially destructible, so it never pins a module through TLS destructors */
+		static inline Table& Local() { static thread_local Table table; return table; }
+	public:
+		/* Asked once per (vtable, iid) when an entry is filled; an object answering it is queried directly every time */
+		static constexpr GUID Uncached = GUID(GUID::Static, dom_guid_pre_name "QueryCache.Uncached");
+
+		/* Called whenever a server module may have been unmapped: its vtables can be reused by another module */
+		static inline void Invalidate() { Epoch().fetch_add(1, std::memory_order_release); }
+
+		static inline bool Query(IUnknown* unkw, const uiid& iid, void **ppv) {
+#ifdef DOM_QI_CACHE
+			auto&& table = Local();
+			auto epoch = Epoch().load(std::memory_order_acquire);
+			if (table.epoch != epoch) { std::memset(table.entries, 0, sizeof(table.entries)); table.epoch = epoch; }
+			const void* vtbl = *reinterpret_cast<const void* const*>(unkw);
+			auto&& e = table.entries[(((uintptr_t)vtbl >> 4) ^ iid.hash()) & (Size - 1)];
+			if (e.vtbl == vtbl && e.iid == iid.hash()) {
+				if (e.offset == Bypass) return unkw->QueryInterface(iid, ppv);
+				if (e.offset == Miss) { *ppv = nullptr; return false; }
+				*ppv = (char*)unkw + e.offset;
+				return true;
+			}
+			void* uncached = nullptr;
+			bool bypass = unkw->QueryInterface(Uncached, &uncached);
+			bool found = unkw->QueryInterface(iid, ppv);
+			e.vtbl = vtbl; e.iid = iid.hash(); e.offset = bypass ? Bypass : found ? (char*)*ppv - (char*)unkw : Miss;
+			return found;
+#else
+			return unkw->QueryInterface(iid, ppv);
+#endif // DOM_QI_CACHE
+		}
+	};
+
+	template <class T> class InterfaceRef;
+
 	template <class T> class Interface
 	{
 	private:
 		T* _i;
+		friend class InterfaceRef<T>;
 	public:
 		Interface() : _i(nullptr) { ; }
-		Interface(IUnknown* unkw) : _i(nullptr) { unkw != nullptr && unkw->QueryInterface(T::guid(), (void**)&_i) && _i->AddRef(); }
+		Interface(IUnknown* unkw) : _i(nullptr) { unkw != nullptr && QueryCache::Query(unkw, T::guid(), (void**)&_i) && _i->AddRef(); }
 		Interface(const Interface<T>&) = delete;
-		Interface(const Interface<T>&& lp) : _i(lp._i) { _i != nullptr && _i->AddRef(); }
+		Interface(Interface<T>&& lp) noexcept : _i(lp._i) { lp._i = nullptr; }
 		~Interface() { Release(); }
 		Interface<T>& operator = (const Interface<T>&) = delete;
-		inline Interface<T>& operator = (const Interface<T>&& lp)
+		inline Interface<T>& operator = (Interface<T>&& lp) noexcept
 		{
-			Release();
-			_i = lp._i;
-			_i != nullptr && _i->AddRef();
+			if (this != &lp) {
+				Release();
+				_i = lp._i;
+				lp._i = nullptr;
+			}
 			return *this;
 		}
-		inline bool QueryInterface(IUnknown* unkw) { Release(); return unkw != nullptr && unkw->QueryInterface(T::guid(), (void**)&_i) && _i->AddRef(); }
+		inline bool QueryInterface(IUnknown* unkw) { Release(); return unkw != nullptr && QueryCache::Query(unkw, T::guid(), (void**)&_i) && _i->AddRef(); }
+		/* Takes over a reference the caller already owns, e.g. from CreateInstance; it is released if T is not implemented */
+		inline bool Attach(IUnknown* unkw) {
+			Release();
+			if (unkw != nullptr && !QueryCache::Query(unkw, T::guid(), (void**)&_i)) { _i = nullptr; unkw->Release(); }
+			return _i != nullptr;
+		}
+		/* Gives up ownership without releasing */
+		inline T* Detach() { T* pTemp = _i; _i = nullptr; return pTemp; }
 		inline operator bool() const { return (_i != nullptr); }
 		inline operator IUnknown* () const { return (IUnknown*)_i; }
 		inline operator T* () const { return _i; }
@@ -30,4 +142,25 @@ namespace Dom {
 		inline void Release() { T* pTemp = _i; _i = nullptr; if (pTemp != nullptr) { pTemp->Release(); } }
 		inline const uiid& guid() { return T::guid(); }
 	};
+
+	/* Borrowed, non-owning view for call parameters: valid while the caller holds its reference, never touches the counter */
+	template <class T> class InterfaceRef
+	{
+	private:
+		T* _i;
+	public:
+		InterfaceRef() : _i(nullptr) { ; }
+		InterfaceRef(T* i) : _i(i) { ; }
+		InterfaceRef(const Interface<T>& i) : _i(i) { ; }
+		template<typename U, typename = typename std::enable_if<!std::is_same<U, T>::value && std::is_base_of<IUnknown, U>::value>::type>
+		InterfaceRef(U* unkw) : _i(nullptr) { unkw != nullptr && QueryCache::Query(unkw, T::guid(), (void**)&_i); }
+		inline operator bool() const { return (_i != nullptr); }
+		inline operator IUnknown* () const { return (IUnknown*)_i; }
+		inline operator T* () const { return _i; }
+		inline T* operator -> () const { return _i; }
+		inline bool operator ! () const { return (_i == nullptr); }
+		/* Owning copy, the only operation that adds a reference */
+		inline Interface<T> Retain() const { Interface<T> result; if (_i != nullptr) { _i->AddRef(); result._i = _i; } return result; }
+		inline const uiid& guid() { return T::guid(); }
+	};
 }
\ No newline at end of file
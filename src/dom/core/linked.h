@@ -0,0 +1,65 @@
+#pragma once
+#include "../IUnknown.h"
+#include "sync.h"
+#include <mutex>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+namespace Dom {
+	namespace Server { class HostAllocator; }
+
+	/* Entry points of a server linked into the executable (DOM_STATIC_SERVER): the Dll* exports of a module,
+	   registered at static initialization instead of looked up with dlsym */
+	struct LinkedServer {
+		const char*		Name;
+		bool(*CreateInstance)(const clsuid&, void**);
+		size_t(*CreateInstanceBatch)(const clsuid&, size_t, void**);
+		bool(*CanUnloadNow)();
+		long(*InstanceCount)(const clsuid&);
+		bool(*RegisterServer)(IUnknown*, std::string&&);
+		bool(*UnRegisterServer)(IUnknown*, std::string&&);
+		bool(*InstallServer)(IUnknown*);
+		bool(*UnInstallServer)(IUnknown*);
+		bool(*Initialize)(IUnknown*);
+		bool(*Finalize)(IUnknown*);
+		ShardedCounter*(*ClassCounter)(const clsuid&);
+		Server::HostAllocator*(*Allocator)();
+	};
+
+	/* A class of a linked server with its own factory: created by a direct call, without the registry lookup */
+	struct LinkedClass {
+		clsuid					ClsId;
+		bool(*Create)(const clsuid& iid, void** ppv);
+		size_t(*CreateBatch)(const clsuid& iid, size_t count, void** ppv);
+		const LinkedServer*		Server;
+	};
+
+	/* Process-wide table of linked servers. Filled before main, so managers constructed during static initialization
+	   may not see every server. Objects of a static archive are only linked when referenced, link server archives
+	   with --whole-archive */
+	class LinkedServers {
+		mutable std::mutex			lock;
+		std::vector<LinkedClass>	classes;
+	public:
+		static inline LinkedServers& Instance() { static LinkedServers instance; return instance; }
+
+		inline void Link(std::initializer_list<LinkedClass> list) {
+			std::unique_lock<std::mutex> sync(lock);
+			classes.insert(classes.end(), list.begin(), list.end());
+		}
+		inline std::vector<LinkedClass> Classes() const {
+			std::unique_lock<std::mutex> sync(lock);
+			return classes;
+		}
+		/* Linked server exporting `cid`, nullptr if none does */
+		inline const LinkedServer* Find(const clsuid& cid) const {
+			std::unique_lock<std::mutex> sync(lock);
+			for (auto&& cls : classes) { if (cls.ClsId == cid) return cls.Server; }
+			return nullptr;
+		}
+		/* Instance counter of a linked class, owned by its server */
+		inline ShardedCounter* Counter(const clsuid& cid) const { auto server = Find(cid); return server != nullptr ? server->ClassCounter(cid) : nullptr; }
+		inline Server::HostAllocator* Allocator(const clsuid& cid) const { auto server = Find(cid); return server != nullptr ? server->Allocator() : nullptr; }
+	};
+}
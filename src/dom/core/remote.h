@@ -0,0 +1,772 @@
+#pragma once
+#include "interface.h"
+#include <new>
+#include <mutex>
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <system_error>
+#include <spawn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+extern char** environ;
+
+namespace Dom {
+	/* Out-of-process servers: a server module runs in a child host process, its objects are used through proxies.
+	   Calls travel through a shared memory region; only interfaces declared with DOM_REMOTE_INTERFACE and a proxy
+	   class registered with DOM_REMOTE_PROXY cross the process boundary */
+	namespace Remote {
+		class Channel;
+
+		/* Bytes passed by reference. Memory from Remote::Allocate already lives in the shared region and is read in place
+		   by the host, any other memory is copied into the region once per call. Valid on the host for the call only */
+		struct Buffer {
+			void*	Data;
+			size_t	Size;
+		};
+
+		static inline void FutexWait(std::atomic<uint32_t>& word, uint32_t value, long nanos) {
+			struct timespec timeout = { nanos / 1000000000L, nanos % 1000000000L };
+			syscall(SYS_futex, &word, FUTEX_WAIT, value, &timeout, nullptr, 0);
+		}
+		static inline void FutexWake(std::atomic<uint32_t>& word) { syscall(SYS_futex, &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0); }
+		/* Busy-wait rounds before sleeping; on one core the other side cannot run while we spin */
+		static inline int Spins(int rounds) { static const bool parallel = std::thread::hardware_concurrency() > 1; return parallel ? rounds : 0; }
+
+		/* Layout of the memory shared by a client and its host. Requests go through a bounded lock-free MPSC queue (any client
+		   thread -> the host thread), each reply lands in the mailbox of its caller. Payloads that do not fit a message and
+		   buffers live in blocks of the same mapping, so neither side copies them again */
+		struct Region {
+			static constexpr uint32_t	Magic = 0x444f4d52;
+			static constexpr uint32_t	None = UINT32_MAX;
+			static constexpr size_t		Slots = 1024, Mailboxes = 256, Blocks = 256, BlockSize = 64 * 1024;
+
+			enum Op : uint32_t { Nop, Classes, Create, Call, Release, Close };
+
+			struct Message {
+				uint32_t	Op;
+				uint32_t	Mailbox;	/* None for posted messages, no reply */
+				uint64_t	Object;		/* Host handle; requested and created count for Create */
+				uint64_t	Key;		/* Proxy class of created objects */
+				uint32_t	Interface;	/* Index of the interface in the proxy class */
+				uint32_t	Method;
+				int32_t		Status;		/* errno of the reply */
+				uint32_t	Length;
+				uint32_t	Block;		/* Payload block, None for an inline payload */
+				uint32_t	Reserved;
+				uint8_t		Inline[208];
+			};
+			struct alignas(64) Cell {
+				std::atomic<uint64_t>	seq;
+				Message					msg;
+			};
+			struct alignas(64) Mailbox {
+				std::atomic<uint32_t>	seq;
+				std::atomic<uint32_t>	waiting;
+				Message					reply;
+			};
+			/* Tagged free list of indexes, the tag in the high half defeats ABA */
+			struct alignas(64) Stack {
+				std::atomic<uint64_t>	head;
+
+				inline void Init(std::atomic<uint32_t>* next, size_t count) {
+					for (size_t n = 0; n < count; n++) next[n].store(n + 1 < count ? (uint32_t)n + 2 : 0, std::memory_order_relaxed);
+					head.store(count ? 1 : 0, std::memory_order_release);
+				}
+				inline uint32_t Pop(std::atomic<uint32_t>* next) {
+					uint64_t top = head.load(std::memory_order_acquire);
+					for (;;) {
+						uint32_t index = (uint32_t)top;
+						if (index == 0) return None;
+						uint64_t pop = ((top >> 32) + 1) << 32 | next[index - 1].load(std::memory_order_relaxed);
+						if (head.compare_exchange_weak(top, pop, std::memory_order_acq_rel, std::memory_order_acquire)) return index - 1;
+					}
+				}
+				inline void Push(std::atomic<uint32_t>* next, uint32_t index) {
+					uint64_t top = head.load(std::memory_order_relaxed);
+					do { next[index].store((uint32_t)top, std::memory_order_relaxed); }
+					while (!head.compare_exchange_weak(top, ((top >> 32) + 1) << 32 | (index + 1), std::memory_order_release, std::memory_order_relaxed));
+				}
+			};
+			static_assert(sizeof(Message) == 256, "Message is four cache lines");
+			static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "Shared atomics must be address-free");
+
+			uint32_t				magic;
+			pid_t					client;
+			alignas(64) std::atomic<uint64_t>	head;	/* Next request cell, claimed by clients */
+			alignas(64) std::atomic<uint64_t>	tail;	/* Next request the host serves */
+			alignas(64) std::atomic<uint32_t>	doorbell;
+			std::atomic<uint32_t>	sleeping;
+			Stack					freeMailboxes;
+			Stack					freeBlocks;
+			Cell					cells[Slots];
+			Mailbox					boxes[Mailboxes];
+			std::atomic<uint32_t>	nextMailbox[Mailboxes];
+			std::atomic<uint32_t>	nextBlock[Blocks];
+			alignas(4096) uint8_t	blocks[Blocks][BlockSize];
+
+			Region() : magic(Magic), client(getpid()), head(0), tail(0), doorbell(0), sleeping(0) {
+				for (size_t n = 0; n < Slots; n++) cells[n].seq.store(n, std::memory_order_relaxed);
+				for (auto&& box : boxes) { box.seq.store(0, std::memory_order_relaxed); box.waiting.store(0, std::memory_order_relaxed); }
+				freeMailboxes.Init(nextMailbox, Mailboxes);
+				freeBlocks.Init(nextBlock, Blocks);
+			}
+
+			inline uint8_t* Payload(Message& msg) { return msg.Block == None ? msg.Inline : blocks[msg.Block]; }
+			inline size_t Capacity(const Message& msg) const { return msg.Block == None ? sizeof(msg.Inline) : BlockSize; }
+			inline bool Contains(const void* data, size_t size) const {
+				auto at = (const uint8_t*)data, end = blocks[Blocks - 1] + BlockSize;
+				return at >= blocks[0] && at <= end && size <= (size_t)(end - at);
+			}
+
+			inline uint32_t Block() { return freeBlocks.Pop(nextBlock); }
+			inline void Free(uint32_t block) { if (block != None) freeBlocks.Push(nextBlock, block); }
+
+			/* Client side: claims the next request cell, nullptr while the queue is full */
+			inline Cell* Claim(uint64_t& pos) {
+				pos = head.load(std::memory_order_relaxed);
+				for (;;) {
+					auto&& cell = cells[pos & (Slots - 1)];
+					int64_t diff = (int64_t)(cell.seq.load(std::memory_order_acquire) - pos);
+					if (diff == 0) { if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &cell; }
+					else if (diff < 0) return nullptr;
+					else pos = head.load(std::memory_order_relaxed);
+				}
+			}
+			/* The doorbell only rings while the host sleeps, a burst of requests costs one wakeup */
+			inline void Publish(Cell& cell, uint64_t pos) {
+				cell.seq.store(pos + 1);
+				if (sleeping.load()) {
+					doorbell.fetch_add(1);
+					FutexWake(doorbell);
+				}
+			}
+
+			/* Host side: the oldest published request, served in place */
+			inline Message* Next() {
+				auto pos = tail.load(std::memory_order_relaxed);
+				auto&& cell = cells[pos & (Slots - 1)];
+				return cell.seq.load() == pos + 1 ? &cell.msg : nullptr;
+			}
+			inline void Done() {
+				auto pos = tail.load(std::memory_order_relaxed);
+				cells[pos & (Slots - 1)].seq.store(pos + Slots, std::memory_order_release);
+				tail.store(pos + 1, std::memory_order_relaxed);
+			}
+			inline void Reply(Mailbox& box) {
+				box.seq.fetch_add(1);
+				if (box.waiting.load()) FutexWake(box.seq);
+			}
+		};
+
+		/* Serialized arguments and results: trivially copyable values, Buffer as its offset in the region */
+		template<typename T>
+		static constexpr size_t Wire() {
+			if constexpr (std::is_void<T>::value) return 0;
+			else if constexpr (std::is_same<T, Buffer>::value) return 2 * sizeof(uint64_t);
+			else return sizeof(T);
+		}
+
+		class Writer {
+			uint8_t*	at;
+			uint8_t*	end;
+		public:
+			Writer(uint8_t* data, size_t size) : at(data), end(data + size) { ; }
+			inline uint8_t* Data() { return at; }
+			inline void Put(const void* data, size_t size) {
+				if (size > (size_t)(end - at)) throw std::system_error(E2BIG, std::system_category(), "Remote payload");
+				std::memcpy(at, data, size);
+				at += size;
+			}
+			template<typename T>
+			inline void Put(const T& value) {
+				static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value, "Remote arguments and results are values or Remote::Buffer");
+				Put(&value, sizeof(T));
+			}
+		};
+
+		class Reader {
+			const uint8_t*	at;
+			const uint8_t*	end;
+			Region&			region;
+		public:
+			Reader(Region& r, const uint8_t* data, size_t size) : at(data), end(data + size), region(r) { ; }
+			inline const uint8_t* Get(size_t size) {
+				if (size > (size_t)(end - at)) throw std::system_error(EPROTO, std::system_category(), "Remote payload");
+				auto data = at;
+				at += size;
+				return data;
+			}
+			inline std::string_view Rest() { auto rest = std::string_view((const char*)at, end - at); at = end; return rest; }
+			template<typename T>
+			inline T Get() {
+				T value;
+				if constexpr (std::is_same<T, Buffer>::value) {
+					uint64_t wire[2];
+					std::memcpy(wire, Get(sizeof(wire)), sizeof(wire));
+					if (wire[0] > sizeof(Region) || !region.Contains((uint8_t*)&region + wire[0], wire[1])) throw std::system_error(EFAULT, std::system_category(), "Remote buffer");
+					value = { (uint8_t*)&region + wire[0], wire[1] };
+				}
+				else {
+					std::memcpy(&value, Get(sizeof(T)), sizeof(T));
+				}
+				return value;
+			}
+		};
+
+		/* Host side of one marshalable interface: calls method `method` of `object` with the arguments in `in` */
+		using Dispatch = void(*)(void* object, uint32_t method, Reader& in, Writer& out);
+
+		template<typename I, typename R, typename ... A>
+		static inline void Invoke(I* object, R(I::*method)(A...), Reader& in, Writer& out) {
+			std::tuple<std::decay_t<A>...> args{ in.template Get<std::decay_t<A>>()... };
+			if constexpr (std::is_void<R>::value) std::apply([&](auto& ... arg) { (object->*method)(arg...); }, args);
+			else out.Put(std::apply([&](auto& ... arg) { return (object->*method)(arg...); }, args));
+		}
+
+		template<typename I, auto ... METHODS>
+		struct Stub {
+			static inline void Call(void* object, uint32_t method, Reader& in, Writer& out) {
+				uint32_t n = 0;
+				bool found = ((n++ == method ? (Invoke((I*)object, METHODS, in, out), true) : false) || ...);
+				if (!found) throw std::system_error(ENOSYS, std::system_category(), "Remote method");
+			}
+		};
+
+		/* Proxy class: interfaces it implements, in order, and how to make one for a host object */
+		struct ProxyClass {
+			static constexpr size_t MaxInterfaces = 8;
+			uint64_t		Key;
+			size_t			Count;
+			const uiid*		Iids[MaxInterfaces];
+			IUnknown*(*Create)(const std::shared_ptr<Channel>& channel, uint64_t object);
+		};
+
+		/* Process-wide tables of stubs and proxy classes, filled at static initialization on both sides */
+		class Marshalers {
+			mutable std::mutex								lock;
+			std::unordered_map<uint64_t, Dispatch>			stubs;
+			std::vector<ProxyClass>							proxies;
+		public:
+			static inline Marshalers& Instance() { static Marshalers instance; return instance; }
+
+			inline bool Add(const uiid& iid, Dispatch dispatch) {
+				std::unique_lock<std::mutex> sync(lock);
+				return stubs.emplace(iid.hash(), dispatch).second;
+			}
+			inline bool Add(const ProxyClass& proxy) {
+				std::unique_lock<std::mutex> sync(lock);
+				proxies.push_back(proxy);
+				return true;
+			}
+			inline Dispatch Stub(uint64_t iid) const {
+				std::unique_lock<std::mutex> sync(lock);
+				auto&& it = stubs.find(iid);
+				return it != stubs.end() ? it->second : nullptr;
+			}
+			inline const ProxyClass* Proxy(uint64_t key) const {
+				std::unique_lock<std::mutex> sync(lock);
+				for (auto&& proxy : proxies) { if (proxy.Key == key) return &proxy; }
+				return nullptr;
+			}
+			/* Registration order, the host picks the first proxy class the object fully implements */
+			inline std::vector<ProxyClass> Proxies() const {
+				std::unique_lock<std::mutex> sync(lock);
+				return proxies;
+			}
+		};
+
+		/* Client end of a host process: spawns it, submits requests and waits for replies. Proxies share it, the host
+		   runs until the last of them and the manager binding are gone */
+		class Channel : public std::enable_shared_from_this<Channel> {
+			Region*				region;
+			int					fd;
+			pid_t				pid;
+			std::string			name;
+			std::atomic_bool	lost;
+
+			static constexpr int	Descriptor = 3;
+			static constexpr int	Spins = 4000;
+			static constexpr long	Poll = 10 * 1000 * 1000;
+		public:
+			static constexpr const char* HostFlag = "--dom-remote-host";
+
+			/* One request: a claimed queue cell, filled in place, and the caller's mailbox unless it is posted */
+			class Request {
+				Channel&			channel;
+				Region::Cell*		cell;
+				uint64_t			pos;
+				uint32_t			mailbox, seq, copies[4];
+				size_t				ncopies;
+				bool				submitted;
+				Writer				out;
+
+				inline Region& region() { return *channel.region; }
+				inline Region::Message& Reply() { return region().boxes[mailbox].reply; }
+				inline uint8_t* Prepare(uint32_t op, uint64_t object, size_t length) {
+					while ((cell = region().Claim(pos)) == nullptr) {
+						if (!channel.Alive()) { Release(); throw std::system_error(ECONNRESET, std::system_category(), channel.name); }
+						std::this_thread::yield();
+					}
+					auto&& msg = cell->msg;
+					msg.Op = op; msg.Mailbox = mailbox; msg.Object = object; msg.Key = 0; msg.Interface = 0; msg.Method = 0; msg.Status = 0;
+					msg.Length = (uint32_t)length; msg.Block = Region::None;
+					if (length > sizeof(msg.Inline)) {
+						if (length > Region::BlockSize || (msg.Block = region().Block()) == Region::None) {
+							Abandon();
+							Release();
+							throw std::system_error(length > Region::BlockSize ? E2BIG : ENOBUFS, std::system_category(), "Remote payload");
+						}
+					}
+					return region().Payload(msg);
+				}
+				/* A claimed cell has to reach the host, as a no-op, or it would stall the queue */
+				inline void Abandon() {
+					cell->msg.Op = Region::Nop; cell->msg.Mailbox = Region::None;
+					submitted = true;
+					region().Publish(*cell, pos);
+				}
+				inline void Release() {
+					for (size_t n = 0; n < ncopies; n++) region().Free(copies[n]);
+					ncopies = 0;
+					if (mailbox != Region::None) { region().freeMailboxes.Push(region().nextMailbox, mailbox); mailbox = Region::None; }
+				}
+			public:
+				Request(Channel& ch, uint32_t op, uint64_t object, size_t length, bool reply)
+					: channel(ch), cell(nullptr), pos(0), mailbox(Region::None), seq(0), copies{}, ncopies(0), submitted(false), out(nullptr, 0) {
+					if (reply) {
+						while ((mailbox = region().freeMailboxes.Pop(region().nextMailbox)) == Region::None) {
+							if (!channel.Alive()) throw std::system_error(ECONNRESET, std::system_category(), channel.name);
+							std::this_thread::yield();
+						}
+						seq = region().boxes[mailbox].seq.load(std::memory_order_acquire);
+					}
+					out = Writer(Prepare(op, object, length), length);
+				}
+				Request(const Request&) = delete;
+				~Request() {
+					if (!submitted) Abandon();
+					else if (mailbox != Region::None) region().Free(Reply().Block);
+					Release();
+				}
+
+				inline void Target(uint32_t iface, uint32_t method) { cell->msg.Interface = iface; cell->msg.Method = method; }
+				inline void Put(const void* data, size_t size) { out.Put(data, size); }
+				template<typename T>
+				inline void Put(const T& value) { out.Put(value); }
+				/* Shared memory goes by offset; anything else is copied into a block held until the reply */
+				inline void Put(const Buffer& buffer) {
+					const void* data = buffer.Data;
+					if (!region().Contains(data, buffer.Size)) {
+						uint32_t block;
+						if (buffer.Size > Region::BlockSize || ncopies == sizeof(copies) / sizeof(copies[0]) || (block = region().Block()) == Region::None) {
+							throw std::system_error(buffer.Size > Region::BlockSize ? E2BIG : ENOBUFS, std::system_category(), "Remote buffer");
+						}
+						copies[ncopies++] = block;
+						std::memcpy(region().blocks[block], buffer.Data, buffer.Size);
+						data = region().blocks[block];
+					}
+					uint64_t wire[2] = { (uint64_t)((const uint8_t*)data - (const uint8_t*)&region()), buffer.Size };
+					out.Put(wire, sizeof(wire));
+				}
+
+				/* Publishes a request without reply, the cell belongs to the host from now on */
+				inline void Post() {
+					submitted = true;
+					region().Publish(*cell, pos);
+				}
+				/* Publishes the request and waits for the reply: spins first, then sleeps on the mailbox, polling the host
+				   process so a crashed host fails the call instead of hanging it */
+				inline const Region::Message& Submit() {
+					Post();
+					auto&& box = region().boxes[mailbox];
+					const int spins = Remote::Spins(Spins);
+					for (int spin = 0; box.seq.load(std::memory_order_acquire) == seq; spin++) {
+						if (spin < spins) continue;
+						if (spin % 64 == 0) std::this_thread::yield();
+						if (spin < 2 * spins) continue;
+						box.waiting.store(1);
+						if (box.seq.load() == seq) FutexWait(box.seq, seq, Poll);
+						box.waiting.store(0);
+						if (box.seq.load(std::memory_order_acquire) == seq && !channel.Alive()) {
+							/* The mailbox may still be written by a host that is not quite gone: leak it */
+							mailbox = Region::None;
+							throw std::system_error(ECONNRESET, std::system_category(), channel.name);
+						}
+					}
+					auto&& reply = box.reply;
+					if (reply.Status != 0) throw std::system_error(reply.Status, std::system_category(), channel.name);
+					return reply;
+				}
+				inline Reader Result() { auto&& reply = Reply(); return Reader(region(), region().Payload(reply), reply.Length); }
+			};
+
+		private:
+			Channel(Region* r, int f, pid_t p, const std::string& n) : region(r), fd(f), pid(p), name(n), lost(false) { ; }
+
+			/* Host exits on Close; one that does not within a second is killed */
+			inline void Reap(bool wait) {
+				for (int n = 0; !lost.load(); n++) {
+					int status;
+					auto rc = waitpid(pid, &status, WNOHANG);
+					if (rc == pid || (rc < 0 && errno == ECHILD)) { lost = true; break; }
+					if (!wait) break;
+					if (n == 100) kill(pid, SIGKILL);
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				}
+			}
+		public:
+			Channel(const Channel&) = delete;
+			~Channel() {
+				if (!lost.load()) {
+					try { Request close(*this, Region::Close, 0, 0, false); close.Post(); }
+					catch (...) { ; }
+					Reap(true);
+				}
+				munmap(region, sizeof(Region));
+				close(fd);
+			}
+
+			/* Starts `Host` (an executable calling Remote::Serve first thing in main) on a fresh region and opens `So` in it.
+			   Throws std::system_error when the host cannot be started or the server does not load */
+			static inline std::shared_ptr<Channel> Spawn(const std::string& Host, const std::string& So) {
+				int fd = memfd_create("dom-remote", MFD_CLOEXEC);
+				if (fd < 0) throw std::system_error(errno, std::system_category(), "memfd_create");
+				if (fd == Descriptor) { int moved = fcntl(fd, F_DUPFD_CLOEXEC, Descriptor + 1); close(fd); fd = moved; }
+				void* mapped = MAP_FAILED;
+				if (ftruncate(fd, sizeof(Region)) != 0 || (mapped = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+					int error = errno;
+					close(fd);
+					throw std::system_error(error, std::system_category(), "Remote region");
+				}
+				auto region = new (mapped) Region();
+
+				posix_spawn_file_actions_t actions;
+				posix_spawn_file_actions_init(&actions);
+				posix_spawn_file_actions_adddup2(&actions, fd, Descriptor);
+				char* argv[] = { (char*)Host.c_str(), (char*)HostFlag, (char*)So.c_str(), nullptr };
+				pid_t pid;
+				int rc = posix_spawn(&pid, Host.c_str(), &actions, nullptr, argv, environ);
+				posix_spawn_file_actions_destroy(&actions);
+				if (rc != 0) {
+					munmap(mapped, sizeof(Region));
+					close(fd);
+					throw std::system_error(rc, std::system_category(), Host);
+				}
+				DOM_CALL_TRACE("%s pid %d", So.c_str(), (int)pid);
+				return std::shared_ptr<Channel>(new Channel(region, fd, pid, So));
+			}
+
+			inline pid_t Pid() const { return pid; }
+			inline const std::string& Name() const { return name; }
+			inline bool Alive() { Reap(false); return !lost.load(); }
+
+			/* Class ids the host serves, with their dom_cls_pre_name prefix; the first reply also tells the server loaded */
+			inline std::vector<std::string> Classes() {
+				Request request(*this, Region::Classes, 0, 0, true);
+				request.Submit();
+				std::vector<std::string> list;
+				for (auto names = request.Result().Rest(); !names.empty(); ) {
+					auto end = std::min(names.find('\0'), names.size());
+					list.emplace_back(names.substr(0, end));
+					names.remove_prefix(std::min(end + 1, names.size()));
+				}
+				return list;
+			}
+
+			/* Up to `count` host objects of class `cid` in one round trip, returned as AddRef'd proxies. A lost host
+			   creates nothing: a class of a crashed server fails like an unregistered one */
+			inline size_t CreateInstances(const clsuid& cid, size_t count, void** ppv) {
+				std::fill(ppv, ppv + count, nullptr);
+				size_t created = 0;
+				try {
+					while (created < count) {
+						size_t batch = std::min<size_t>(count - created, Region::BlockSize / sizeof(uint64_t));
+						Request request(*this, Region::Create, batch, cid.length(), true);
+						request.Put(cid.c_str(), cid.length());
+						auto&& reply = request.Submit();
+						if (reply.Object == 0) break;
+						auto proxy = Marshalers::Instance().Proxy(reply.Key);
+						auto result = request.Result();
+						for (size_t n = 0; n < reply.Object; n++) {
+							auto object = result.Get<uint64_t>();
+							if (proxy == nullptr) { Release(object); continue; }
+							auto unkn = proxy->Create(shared_from_this(), object);
+							unkn->AddRef();
+							ppv[created++] = unkn;
+						}
+						if (proxy == nullptr) {
+							DOM_ERR("Proxy class %lx of `%s/%s` is not registered with DOM_REMOTE_PROXY", (unsigned long)reply.Key, name.c_str(), cid.c_str());
+							break;
+						}
+						if (reply.Object < batch) break;
+					}
+				}
+				catch (std::system_error& ex) {
+					DOM_ERR("Remote `%s` create `%s`: %s", name.c_str(), cid.c_str(), ex.what());
+					if (Alive()) throw;
+				}
+				return created;
+			}
+			inline bool CreateInstance(const clsuid& cid, void** ppv) { return CreateInstances(cid, 1, ppv) == 1; }
+
+			/* Posted, never waits: the host releases the object with the next batch it serves */
+			inline void Release(uint64_t object) noexcept {
+				if (!Alive()) return;
+				try { Request release(*this, Region::Release, object, 0, false); release.Post(); }
+				catch (...) { ; }
+			}
+
+			/* Shared memory for zero-copy Buffer arguments, at most Region::BlockSize bytes */
+			inline Buffer Allocate(size_t size) {
+				uint32_t block;
+				if (size > Region::BlockSize || (block = region->Block()) == Region::None) return { nullptr, 0 };
+				return { region->blocks[block], size };
+			}
+			inline void Free(const Buffer& buffer) {
+				if (buffer.Data != nullptr && region->Contains(buffer.Data, 1)) region->Free((uint32_t)(((uint8_t*)buffer.Data - region->blocks[0]) / Region::BlockSize));
+			}
+
+		};
+
+		/* What every proxy object answers besides its interfaces */
+		struct IProxy : virtual public IUnknown {
+			virtual Channel& Host() = 0;
+			virtual uint64_t Handle() = 0;
+
+			IID(RemoteProxy)
+		};
+
+		/* Base of a hand-written proxy class: PROXY implements every method of IFACES as one Invoke call, e.g.
+			class HelloProxy : public Dom::Remote::Proxy<HelloProxy, IHello> {
+			public:
+				using Proxy::Proxy;
+				virtual void Say() { Invoke<IHello, 0>(); }
+			};
+		   Method numbers are positions in the DOM_REMOTE_INTERFACE list of the interface */
+		template<typename PROXY, typename ... IFACES>
+		class Proxy : public IProxy, public IFACES... {
+			static_assert(sizeof...(IFACES) > 0 && sizeof...(IFACES) <= ProxyClass::MaxInterfaces, "A proxy class marshals 1 to ProxyClass::MaxInterfaces interfaces");
+			std::shared_ptr<Channel>	channel;
+			uint64_t					object;
+			std::atomic_long			refs;
+
+			template<typename I>
+			static constexpr uint32_t Index() {
+				constexpr bool match[] = { std::is_same<I, IFACES>::value... };
+				for (uint32_t n = 0; n < sizeof...(IFACES); n++) { if (match[n]) return n; }
+				return Region::None;
+			}
+		protected:
+			template<typename I, uint32_t METHOD, typename R = void, typename ... A>
+			inline R Invoke(const A& ... args) {
+				static_assert(Index<I>() != Region::None, "Interface not marshaled by this proxy");
+				static_assert(Wire<R>() <= sizeof(Region::Message::Inline), "Remote result too large");
+				Channel::Request request(*channel, Region::Call, object, (Wire<A>() + ... + 0), true);
+				request.Target(Index<I>(), METHOD);
+				(request.Put(args), ...);
+				request.Submit();
+				if constexpr (!std::is_void<R>::value) return request.Result().template Get<R>();
+			}
+		public:
+			Proxy(const std::shared_ptr<Channel>& ch, uint64_t handle) : channel(ch), object(handle), refs(0) { ; }
+			virtual ~Proxy() { channel->Release(object); }
+
+			static inline ProxyClass Class() {
+				ProxyClass cls = { 0, sizeof...(IFACES), { &IFACES::guid()... }, &Create };
+				cls.Key = 0xcbf29ce484222325ull;
+				for (size_t n = 0; n < cls.Count; n++) cls.Key = (cls.Key ^ cls.Iids[n]->hash()) * 0x100000001b3ull;
+				return cls;
+			}
+			static inline IUnknown* Create(const std::shared_ptr<Channel>& channel, uint64_t object) { return static_cast<IProxy*>(new PROXY(channel, object)); }
+
+			inline virtual Channel& Host() { return *channel; }
+			inline virtual uint64_t Handle() { return object; }
+
+			inline virtual long AddRef() { return refs.fetch_add(1, std::memory_order_relaxed) + 1; }
+			inline virtual long Release() {
+				long n = refs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+				if (n == 0) delete static_cast<PROXY*>(this);
+				return n;
+			}
+			inline virtual bool QueryInterface(const uiid& iid, void **ppv) { return InterfaceTable<Proxy, IProxy, IFACES...>::Query(this, iid, ppv); }
+		};
+
+		/* Zero-copy buffer for calls on `object`: shared memory of its host for a proxy, heap memory for a local object */
+		static inline Buffer Allocate(IUnknown* object, size_t size) {
+			IProxy* proxy;
+			if (object != nullptr && object->QueryInterface(IProxy::guid(), (void**)&proxy)) return proxy->Host().Allocate(size);
+			auto data = std::malloc(size);
+			return { data, data != nullptr ? size : 0 };
+		}
+		static inline void Free(IUnknown* object, const Buffer& buffer) {
+			IProxy* proxy;
+			if (object != nullptr && object->QueryInterface(IProxy::guid(), (void**)&proxy)) proxy->Host().Free(buffer);
+			else std::free(buffer.Data);
+		}
+
+		/* Host side: serves the region on the calling thread until the client closes it or goes away */
+		class Server {
+			struct Handle {
+				IUnknown*		Object;
+				size_t			Count;
+				void*			Interfaces[ProxyClass::MaxInterfaces];
+				Dispatch		Stubs[ProxyClass::MaxInterfaces];
+			};
+			Region&											region;
+			std::vector<std::string>						classes;
+			std::function<bool(const clsuid&, void**)>		create;
+			std::vector<Handle>								handles;
+			std::vector<uint64_t>							freeHandles;
+			std::vector<ProxyClass>							proxies;
+			std::unordered_map<uint64_t, const ProxyClass*>	classProxy;
+			static constexpr int	Spins = 20000;
+			static constexpr long	Poll = 100 * 1000 * 1000;
+
+			inline bool Bind(const ProxyClass& proxy, IUnknown* object, Handle& handle) {
+				for (size_t n = 0; n < proxy.Count; n++) {
+					handle.Stubs[n] = Marshalers::Instance().Stub(proxy.Iids[n]->hash());
+					if (handle.Stubs[n] == nullptr || !object->QueryInterface(*proxy.Iids[n], &handle.Interfaces[n])) return false;
+				}
+				handle.Count = proxy.Count;
+				return true;
+			}
+			/* First registered proxy class whose every interface the object implements and the host can dispatch */
+			inline const ProxyClass* Select(IUnknown* object, Handle& handle) {
+				for (auto&& proxy : proxies) { if (Bind(proxy, object, handle)) return &proxy; }
+				return nullptr;
+			}
+			inline uint64_t Open(const Handle& handle) {
+				if (freeHandles.empty()) { handles.push_back(handle); return handles.size(); }
+				auto id = freeHandles.back();
+				freeHandles.pop_back();
+				handles[id - 1] = handle;
+				return id;
+			}
+			inline Handle* Find(uint64_t id) { return id != 0 && id <= handles.size() && handles[id - 1].Object != nullptr ? &handles[id - 1] : nullptr; }
+			inline void Close(uint64_t id) {
+				if (auto handle = Find(id)) {
+					handle->Object->Release();
+					handle->Object = nullptr;
+					freeHandles.push_back(id);
+				}
+			}
+
+			inline void Created(Region::Message& msg, Region::Message& reply, Writer& out) {
+				auto payload = region.Payload(msg);
+				std::string cid((const char*)payload, msg.Length);
+				if (cid.compare(0, sizeof(dom_cls_pre_name) - 1, dom_cls_pre_name) == 0) cid.erase(0, sizeof(dom_cls_pre_name) - 1);
+				clsuid clsId(cid);
+				auto&& memo = classProxy.emplace(clsId.hash(), nullptr).first;
+				uint64_t n = 0;
+				for (; n < msg.Object; n++) {
+					IUnknown* object;
+					if (!create(clsId, (void**)&object)) break;
+					Handle handle = { object, 0, {}, {} };
+					if (memo->second != nullptr ? !Bind(*memo->second, object, handle) : (memo->second = Select(object, handle)) == nullptr) {
+						DOM_ERR("Class `%s` implements no interface of a registered proxy class", cid.c_str());
+						object->Release();
+						break;
+					}
+					out.Put(Open(handle));
+				}
+				reply.Object = n;
+				reply.Key = memo->second != nullptr ? memo->second->Key : 0;
+			}
+
+			/* Serves one request in place; false once the client closed the region */
+			inline bool Serve(Region::Message& msg) {
+				if (msg.Op == Region::Close) return false;
+				if (msg.Op == Region::Nop) { region.Free(msg.Block); return true; }
+				Region::Mailbox* box = msg.Mailbox < Region::Mailboxes ? &region.boxes[msg.Mailbox] : nullptr;
+				Region::Message scratch;
+				auto&& reply = box != nullptr ? box->reply : scratch;
+				reply.Op = msg.Op; reply.Mailbox = msg.Mailbox; reply.Object = 0; reply.Key = 0; reply.Status = 0; reply.Length = 0; reply.Block = Region::None;
+				bool large = msg.Op == Region::Classes || (msg.Op == Region::Create && msg.Object * sizeof(uint64_t) > sizeof(reply.Inline));
+				if (large && box != nullptr && (reply.Block = region.Block()) == Region::None) reply.Status = ENOBUFS;
+				Writer out(region.Payload(reply), region.Capacity(reply));
+				auto start = out.Data();
+				try {
+					if (reply.Status != 0) { ; }
+					else if (msg.Op == Region::Classes) {
+						for (auto&& cls : classes) out.Put(cls.c_str(), cls.length() + 1);
+					}
+					else if (msg.Op == Region::Create) {
+						Created(msg, reply, out);
+					}
+					else if (msg.Op == Region::Call) {
+						auto handle = Find(msg.Object);
+						if (handle == nullptr || msg.Interface >= handle->Count) throw std::system_error(EBADF, std::system_category(), "Remote object");
+						Reader in(region, region.Payload(msg), msg.Length);
+						handle->Stubs[msg.Interface](handle->Interfaces[msg.Interface], msg.Method, in, out);
+					}
+					else if (msg.Op == Region::Release) {
+						Close(msg.Object);
+					}
+				}
+				catch (std::system_error& ex) { reply.Status = ex.code().value(); }
+				catch (...) { reply.Status = EREMOTEIO; }
+				reply.Length = (uint32_t)(out.Data() - start);
+				region.Free(msg.Block);
+				if (box != nullptr) region.Reply(*box);
+				else region.Free(reply.Block);
+				return true;
+			}
+		public:
+			Server(Region& r, std::vector<std::string>&& list, std::function<bool(const clsuid&, void**)>&& fn)
+				: region(r), classes(std::move(list)), create(std::move(fn)), proxies(Marshalers::Instance().Proxies()) { ; }
+			~Server() { for (size_t id = 1; id <= handles.size(); id++) Close(id); }
+
+			/* Drains every published request before it sleeps: a burst is served in one batch, replies go out as they complete */
+			inline int Run() {
+				for (;;) {
+					bool served = false;
+					while (auto msg = region.Next()) {
+						bool open = Serve(*msg);
+						region.Done();
+						if (!open) return 0;
+						served = true;
+					}
+					if (served) continue;
+					for (int spin = 0, spins = Remote::Spins(Spins); spin < spins && region.Next() == nullptr; spin++) { ; }
+					if (region.Next() != nullptr) continue;
+					auto bell = region.doorbell.load();
+					region.sleeping.store(1);
+					if (region.Next() == nullptr) FutexWait(region.doorbell, bell, Poll);
+					region.sleeping.store(0);
+					if (getppid() != region.client) return 1;
+				}
+			}
+		};
+	}
+}
+
+/* Registers the host side of interface `IFACE`: its marshalable methods in order, each taking and returning values or Remote::Buffer */
+#define DOM_REMOTE_INTERFACE(IFACE, ...) \
+	static const bool __dom_remote_stub_##IFACE = Dom::Remote::Marshalers::Instance().Add(IFACE::guid(), &Dom::Remote::Stub<IFACE, __VA_ARGS__>::Call);
+
+/* Registers proxy class `PROXY` (a Dom::Remote::Proxy) with the client side */
+#define DOM_REMOTE_PROXY(PROXY) \
+	static const bool __dom_remote_proxy_##PROXY = Dom::Remote::Marshalers::Instance().Add(PROXY::Class());
@@ -0,0 +1,102 @@
+#pragma once
+#include "../guid.h"
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <string_view>
+
+namespace Dom {
+
+	/* Process-wide, insert-only scope tree. Every scope is interned once, together with its parent (`a/b` -> `a` -> ``),
+	   so a scope is identified by one pointer in every manager and every table snapshot. Readers never lock.
+	   Entries are never freed: only binding a class interns, lookups use Lookup() */
+	class ScopePool {
+	public:
+		struct Entry {
+			const Entry*	next;
+			const Entry*	parent;
+			uint64_t		hash;
+			uint32_t		id;
+			size_t			length;
+			char			name[1];
+		};
+	private:
+		static constexpr size_t Buckets = 1024;
+		std::atomic<const Entry*>	pool[Buckets];
+		std::atomic<uint32_t>		count;
+		const Entry*				global;
+
+		static inline const Entry* Find(const Entry* e, const Entry* last, uint64_t hash, std::string_view name) {
+			for (; e != last; e = e->next) { if (e->hash == hash && e->length == name.length() && std::memcmp(e->name, name.data(), name.length()) == 0) return e; }
+			return nullptr;
+		}
+		ScopePool() : pool{}, count(0), global(nullptr) { global = Intern(std::string_view()); }
+	public:
+		ScopePool(const ScopePool&) = delete;
+
+		inline const Entry* Global() const { return global; }
+		inline size_t Interned() const { return count.load(std::memory_order_relaxed); }
+
+		/* Find-only, nullptr for a scope nothing was ever bound in */
+		inline const Entry* Lookup(std::string_view name) const {
+			if (name.empty()) return global;
+			uint64_t hash = GuidFold(name.data(), name.length());
+			return Find(pool[hash & (Buckets - 1)].load(std::memory_order_acquire), nullptr, hash, name);
+		}
+
+		inline const Entry* Intern(std::string_view name) {
+			if (name.empty() && global != nullptr) return global;
+			uint64_t hash = GuidFold(name.data(), name.length());
+			auto&& bucket = pool[hash & (Buckets - 1)];
+			const Entry* head = bucket.load(std::memory_order_acquire);
+			if (auto e = Find(head, nullptr, hash, name)) return e;
+
+			auto pos = name.rfind('/');
+			const Entry* parent = name.empty() ? nullptr : Intern(pos == std::string_view::npos ? std::string_view() : name.substr(0, pos));
+			Entry* entry = (Entry*)std::malloc(sizeof(Entry) + name.length());
+			if (entry == nullptr) throw std::bad_alloc();
+			entry->parent = parent; entry->hash = hash; entry->id = count.fetch_add(1, std::memory_order_relaxed); entry->length = name.length();
+			if (!name.empty()) std::memcpy(entry->name, name.data(), name.length());
+			entry->name[name.length()] = '\0';
+			entry->next = head;
+			while (!bucket.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_acquire)) {
+				if (auto e = Find(entry->next, head, hash, name)) { std::free(entry); return e; }
+				head = entry->next;
+			}
+			return entry;
+		}
+
+		static inline ScopePool& Instance() { static ScopePool instance; return instance; }
+	};
+
+	/* Interned scope: comparing, hashing and walking to the parent never touch the string */
+	class ScopeId {
+		const ScopePool::Entry*	entry;
+	public:
+		struct Hash {
+			inline size_t operator()(const ScopeId& id) const { return id.hash(); }
+		};
+		/* No scope at all, what Parent() of the global scope and Lookup() of an unknown one return */
+		ScopeId() : entry(nullptr) { ; }
+		ScopeId(const ScopePool::Entry* e) : entry(e) { ; }
+		/* Interns `name`, for binding only */
+		explicit ScopeId(std::string_view name) : entry(ScopePool::Instance().Intern(name)) { ; }
+		explicit ScopeId(const std::string& name) : ScopeId(std::string_view(name)) { ; }
+		explicit ScopeId(const char* name) : ScopeId(std::string_view(name)) { ; }
+
+		static inline ScopeId Global() { return ScopeId(ScopePool::Instance().Global()); }
+		static inline ScopeId Lookup(std::string_view name) { return ScopeId(ScopePool::Instance().Lookup(name)); }
+
+		inline bool operator == (const ScopeId& WithThis) const { return entry == WithThis.entry; }
+		inline bool operator != (const ScopeId& WithThis) const { return entry != WithThis.entry; }
+		inline explicit operator bool() const { return entry != nullptr; }
+		inline ScopeId Parent() const { return ScopeId(entry != nullptr ? entry->parent : nullptr); }
+
+		inline size_t hash() const { return entry != nullptr ? entry->hash : 0; }
+		inline uint32_t id() const { return entry != nullptr ? entry->id : UINT32_MAX; }
+		inline std::string_view name() const { return entry != nullptr ? std::string_view(entry->name, entry->length) : std::string_view(); }
+		inline std::string str() const { return std::string(name()); }
+	};
+}
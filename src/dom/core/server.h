@@ -1,18 +1,163 @@
 #pragma once
 #include "../IRegistry.h"
+#include "../IAllocator.h"
+#include "interface.h"
+#include "sync.h"
+#include "linked.h"
+#include "descriptor.h"
+#include <pthread.h>
 #include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 
 namespace Dom {
 	namespace Server {
 
-		struct cast_interface {
-			const uiid	ciid;
-			void*		cpv;
-			template<typename TP>
-			cast_interface(const uiid iid, TP* pv) : ciid(iid), cpv(pv) { ; }
-			inline bool cast(const uiid& iid, void **ppv) const { if (ciid == iid) { *ppv = cpv; return true; }return false; }
+		/* Opt-in instance pooling, declared by the class: `using pool_policy = Dom::Server::Pool<>;`
+		   MAGAZINE blocks are cached per thread, up to DEPOT more are shared between threads */
+		template<size_t MAGAZINE = 32, size_t DEPOT = 1024>
+		struct Pool {
+			static constexpr size_t Magazine = MAGAZINE;
+			static constexpr size_t Depot = DEPOT;
+		};
+
+		template<typename T, typename = void>
+		struct PoolOf { using type = void; };
+		template<typename T>
+		struct PoolOf<T, std::void_t<typename T::pool_policy>> { using type = typename T::pool_policy; };
+
+		/* Freelist of raw sizeof(T) blocks: objects are still constructed and destroyed, only the allocation is reused.
+		   Holds no module references, thread magazines are flushed by a pthread key destructor and everything is freed with the module */
+		template<typename T, typename POLICY>
+		class ObjectPool {
+			struct Magazine {
+				size_t	count;
+				void*	items[POLICY::Magazine];
+			};
+			std::mutex				lock;
+			std::vector<void*>		depot;
+			std::vector<Magazine*>	magazines;
+			std::atomic_size_t		limit;
+			pthread_key_t			key;
+			bool					keyed;
+
+			static inline void Flush(void* local) {
+				auto mag = (Magazine*)local;
+				auto&& pool = Instance();
+				pool.Drain(mag->items, mag->count);
+				std::unique_lock<std::mutex> sync(pool.lock);
+				pool.magazines.erase(std::find(pool.magazines.begin(), pool.magazines.end(), mag));
+				delete mag;
+			}
+			inline Magazine* Local() {
+				auto mag = keyed ? (Magazine*)pthread_getspecific(key) : nullptr;
+				if (mag == nullptr && keyed) {
+					mag = new (std::nothrow) Magazine();
+					if (mag == nullptr || pthread_setspecific(key, mag) != 0) { delete mag; return nullptr; }
+					std::unique_lock<std::mutex> sync(lock);
+					magazines.push_back(mag);
+				}
+				return mag;
+			}
+			/* Moves blocks to the depot, frees what does not fit */
+			inline void Drain(void** items, size_t count) {
+				std::unique_lock<std::mutex> sync(lock);
+				size_t cap = limit.load(std::memory_order_relaxed);
+				for (size_t n = 0; n < count; n++) {
+					if (depot.size() < cap) depot.push_back(items[n]); else ::operator delete(items[n]);
+				}
+			}
+			ObjectPool() : limit(POLICY::Depot), keyed(pthread_key_create(&key, &Flush) == 0) { depot.reserve(POLICY::Depot); }
+		public:
+			/* Runs on dlclose: magazines of threads still alive are released here, their key destructors will not fire */
+			~ObjectPool() {
+				if (keyed) pthread_key_delete(key);
+				for (auto mag : magazines) {
+					for (size_t n = 0; n < mag->count; n++) ::operator delete(mag->items[n]);
+					delete mag;
+				}
+				for (auto block : depot) ::operator delete(block);
+			}
+			static inline ObjectPool& Instance() { static ObjectPool pool; return pool; }
+
+			inline void* Allocate() {
+				if (auto mag = Local()) {
+					if (mag->count == 0) {
+						std::unique_lock<std::mutex> sync(lock);
+						while (mag->count < POLICY::Magazine / 2 && !depot.empty()) { mag->items[mag->count++] = depot.back(); depot.pop_back(); }
+					}
+					if (mag->count != 0) return mag->items[--mag->count];
+				}
+				return ::operator new(sizeof(T));
+			}
+			inline void Deallocate(void* block) {
+				if (auto mag = Local()) {
+					if (mag->count == POLICY::Magazine) {
+						Drain(mag->items + POLICY::Magazine / 2, POLICY::Magazine - POLICY::Magazine / 2);
+						mag->count = POLICY::Magazine / 2;
+					}
+					mag->items[mag->count++] = block;
+					return;
+				}
+				::operator delete(block);
+			}
+
+			/* Depot cap, takes effect on the next flush */
+			inline void Limit(size_t blocks) { limit = blocks; }
+			/* Frees the shared depot and the calling thread's magazine */
+			inline void Trim() {
+				if (auto mag = keyed ? (Magazine*)pthread_getspecific(key) : nullptr) {
+					for (size_t n = 0; n < mag->count; n++) ::operator delete(mag->items[n]);
+					mag->count = 0;
+				}
+				std::unique_lock<std::mutex> sync(lock);
+				for (auto block : depot) ::operator delete(block);
+				depot.clear();
+			}
+		};
+
+		template<typename T, typename POLICY = typename PoolOf<T>::type>
+		struct Pooling {
+			static inline void* Allocate(size_t size) { return size == sizeof(T) ? ObjectPool<T, POLICY>::Instance().Allocate() : ::operator new(size); }
+			static inline void Deallocate(void* block, size_t size) { if (size == sizeof(T)) ObjectPool<T, POLICY>::Instance().Deallocate(block); else ::operator delete(block); }
+			static inline void Trim() { ObjectPool<T, POLICY>::Instance().Trim(); }
+		};
+		template<typename T>
+		struct Pooling<T, void> {
+			static inline void* Allocate(size_t size) { return ::operator new(size); }
+			static inline void Deallocate(void* block, size_t) { ::operator delete(block); }
+			static inline void Trim() { ; }
+		};
+
+		/* Allocator the host offered in DllInitialize. Fixed for the life of the module image by the first Initialize or the first
+		   allocation, whichever comes first, so every object is freed by the allocator that made it */
+		class HostAllocator {
+			std::atomic<IAllocator*>	allocator;
+			static inline IAllocator* Heap() { return reinterpret_cast<IAllocator*>(std::uintptr_t(1)); }
+		public:
+			HostAllocator() : allocator(nullptr) { ; }
+			HostAllocator(const HostAllocator&) = delete;
+			~HostAllocator() { auto host = allocator.load(); if (host != nullptr && host != Heap()) host->Release(); }
+
+			/* False once objects were allocated from the module heap or another allocator was adopted */
+			inline bool Adopt(IAllocator* host) {
+				IAllocator* none = nullptr;
+				if (allocator.compare_exchange_strong(none, host, std::memory_order_acq_rel)) { host->AddRef(); return true; }
+				return none == host;
+			}
+			/* nullptr means the module heap (and class pools) */
+			inline IAllocator* Get() {
+				IAllocator* host = allocator.load(std::memory_order_acquire);
+				if (host == nullptr) allocator.compare_exchange_strong(host, Heap(), std::memory_order_acq_rel, std::memory_order_acquire);
+				return host == nullptr || host == Heap() ? nullptr : host;
+			}
 		};
 
 		/* Object server interfaces implement */
@@ -24,92 +169,395 @@ namespace Dom {
 			Object() : refs(0) { ; }
 			virtual ~Object() { ; }
 
+			/* What QueryInterface answers, IUnknown first; published in the server descriptor */
+			static constexpr const char* InterfaceIds[] = { IUnknown::guid().c_str(), IFACES::guid().c_str()... };
+			static constexpr uint32_t InterfaceCount = sizeof...(IFACES) + 1;
+
+			/* Live instances of T, registered with the module on first use; they keep the module from unloading */
+			static inline ShardedCounter& Instances() {
+#ifdef DOM_STATIC_SERVER
+				static ShardedCounter unlinked;
+				static ShardedCounter* counter = []() { auto linked = LinkedServers::Instance().Counter(T::guid()); return linked != nullptr ? linked : &unlinked; }();
+#else
+				static ShardedCounter* counter = []() { extern ShardedCounter* DllClassCounter(const clsuid&); return DllClassCounter(T::guid()); }();
+#endif // DOM_STATIC_SERVER
+				return *counter;
+			}
+
+			/* Module allocator, see HostAllocator */
+			static inline HostAllocator& Allocator() {
+#ifdef DOM_STATIC_SERVER
+				static HostAllocator unlinked;
+				static HostAllocator* host = []() { auto linked = LinkedServers::Instance().Allocator(T::guid()); return linked != nullptr ? linked : &unlinked; }();
+#else
+				static HostAllocator* host = []() { extern HostAllocator* DllClassAllocator(const clsuid&); return DllClassAllocator(T::guid()); }();
+#endif // DOM_STATIC_SERVER
+				return *host;
+			}
+
+			static inline void* operator new(size_t size) {
+				if (auto host = Allocator().Get()) {
+					if (auto block = host->Allocate(size, alignof(T))) return block;
+					throw std::bad_alloc();
+				}
+				return Pooling<T>::Allocate(size);
+			}
+			static inline void operator delete(void* block, size_t size) {
+				if (auto host = Allocator().Get()) host->Deallocate(block, size, alignof(T));
+				else Pooling<T>::Deallocate(block, size);
+			}
+
 			inline virtual long AddRef() {
 #ifdef DEBUG
 				if (refs < 0) {
 					long _refs = refs;
-					fprintf(stderr, "`Object::uiid(%s)` was to be destroyed. Incorrect reference counter (%ld < 0). `%s:%ls`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
+					fprintf(stderr, "`Object::uiid(%s)` was to be destroyed. Incorrect reference counter (%ld < 0). `%s:%d`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
 				}
 #endif // DEBUG
-				if (refs == 0) { extern long DllRefIncrement(); DllRefIncrement(); }
-				DOM_CALL_TRACE("Refs<%ld>", (long)refs + 1);
-				return ++refs;
+				long n = RefCountOf<T>::type::Increment(refs);
+				if (n == 1) { Instances().Add(1); }
+				DOM_CALL_TRACE("Refs<%ld>", n);
+				return n;
 			}
 			inline virtual long Release() {
-				if ((--refs) == 0) { extern long DllRefDecrement(); DllRefDecrement();  delete static_cast<T*>(this); return 0; }
+				long n = RefCountOf<T>::type::Decrement(refs);
+				if (n == 0) { delete static_cast<T*>(this); Instances().Add(-1); return 0; }
 #ifdef DEBUG
-				if (refs < 0) {
-					long _refs = refs;
-					fprintf(stderr, "Incorrect release of `Object::uiid(%s)`. Reference counter less zero (%ld). `%s:%ls`\n", T::guid().c_str(), _refs, __PRETTY_FUNCTION__, __LINE__);
+				if (n < 0) {
+					fprintf(stderr, "Incorrect release of `Object::uiid(%s)`. Reference counter less zero (%ld). `%s:%d`\n", T::guid().c_str(), n, __PRETTY_FUNCTION__, __LINE__);
 				}
 #endif // DEBUG
-				DOM_CALL_TRACE("Refs<%ld>", (long)refs);
-				return refs;
+				DOM_CALL_TRACE("Refs<%ld>", n);
+				return n;
 			}
 			inline virtual bool QueryInterface(const uiid& iid, void **ppv) {
-				const cast_interface guids[] = { cast_interface(IFACES::guid(),(IFACES*)this)...,cast_interface(IUnknown::guid(),(IUnknown*)this) };
-				*ppv = nullptr;
-				for (auto&& it : guids) {
-					if (it.cast(iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
-				}
+				if (InterfaceTable<Object, IFACES...>::Query(this, iid, ppv)) { DOM_CALL_TRACE("`%s`", iid.c_str()); return true; }
 #ifdef DEBUG
-				fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%ls`\n", iid.c_str(), T::guid().c_str(), __PRETTY_FUNCTION__, __LINE__);
+				if (iid != QueryCache::Uncached) fprintf(stderr, "Interface `uiid(%s)` for `uiid(%s)` not implemented. `%s:%d`\n", iid.c_str(), T::guid().c_str(), __PRETTY_FUNCTION__, __LINE__);
 #endif // DEBUG
 				return false;
 			}
+			/* Tells an activation cache whether it holds the only reference */
+			inline long References() const { return refs.load(std::memory_order_acquire); }
+		};
+
+		/* Activation models, declared by the class: `using activation_policy = Dom::Server::Activation::Singleton;`
+		   All but PerCall hand out a cached object with one AddRef. The cache keeps a reference of its own, which neither
+		   DllCanUnloadNow nor the sweeper count, and drops it in DllFinalize */
+		namespace Activation {
+			/* A new object per CreateInstance, the default */
+			struct PerCall { static constexpr uint32_t Model = ServerDescriptor::PerCall, Slots = 0; };
+			/* One object per module image, created by the first CreateInstance */
+			struct Singleton { static constexpr uint32_t Model = ServerDescriptor::Singleton, Slots = 1; };
+			/* One object per calling thread, released when the thread exits */
+			struct PerThread { static constexpr uint32_t Model = ServerDescriptor::PerThread, Slots = 0; };
+			/* SIZE shared objects, a thread always gets the same one */
+			template<size_t SIZE = 8>
+			struct Pooled { static constexpr uint32_t Model = ServerDescriptor::Pooled, Slots = SIZE; };
+		}
+
+		template<typename T, typename = void>
+		struct ActivationOf { using type = Activation::PerCall; };
+		template<typename T>
+		struct ActivationOf<T, std::void_t<typename T::activation_policy>> { using type = typename T::activation_policy; };
+
+		/* Acquire() returns an AddRef'd object; Idle() counts cached objects nobody else references; Teardown() drops the cache
+		   and runs with no call in flight. A cache not torn down is leaked, never destroyed behind the module's back */
+		template<typename T, typename POLICY = typename ActivationOf<T>::type>
+		class Activator;
+
+		template<typename T>
+		class Activator<T, Activation::PerCall> {
+		public:
+			static inline T* Acquire() { T* object = new T; object->AddRef(); return object; }
+			static inline long Idle() { return 0; }
+			static inline void Teardown() { ; }
+		};
+
+		/* Double-checked creation under a lock, so concurrent first calls share one object */
+		template<typename T>
+		class Activator<T, Activation::Singleton> {
+			std::atomic<T*>		instance;
+			std::mutex			lock;
+
+			Activator() : instance(nullptr) { ; }
+			static inline Activator& Instance() { static Activator activator; return activator; }
+		public:
+			static inline T* Acquire() {
+				auto&& self = Instance();
+				T* object = self.instance.load(std::memory_order_acquire);
+				if (object == nullptr) {
+					std::unique_lock<std::mutex> sync(self.lock);
+					if ((object = self.instance.load(std::memory_order_relaxed)) == nullptr) {
+						object = new T;
+						object->AddRef();
+						self.instance.store(object, std::memory_order_release);
+					}
+				}
+				object->AddRef();
+				return object;
+			}
+			static inline long Idle() { T* object = Instance().instance.load(std::memory_order_acquire); return object != nullptr && object->References() == 1 ? 1 : 0; }
+			static inline void Teardown() {
+				auto&& self = Instance();
+				T* object;
+				{
+					std::unique_lock<std::mutex> sync(self.lock);
+					object = self.instance.exchange(nullptr, std::memory_order_acq_rel);
+				}
+				if (object != nullptr) object->Release();
+			}
+		};
+
+		/* Thread objects hang off a pthread key, like pool magazines: released by the key destructor at thread exit, or by
+		   Teardown for threads still alive; whichever takes the object out of the list releases it */
+		template<typename T>
+		class Activator<T, Activation::PerThread> {
+			std::mutex			lock;
+			std::atomic_bool	keyed;
+			pthread_key_t		key;
+			std::vector<T*>		objects;
+
+			Activator() : keyed(false) { ; }
+			static inline Activator& Instance() { static Activator activator; return activator; }
+			static inline void Exit(void* local) {
+				auto&& self = Instance();
+				{
+					std::unique_lock<std::mutex> sync(self.lock);
+					auto&& it = std::find(self.objects.begin(), self.objects.end(), (T*)local);
+					if (it == self.objects.end()) return;
+					self.objects.erase(it);
+				}
+				((T*)local)->Release();
+			}
+		public:
+			static inline T* Acquire() {
+				auto&& self = Instance();
+				T* object = self.keyed.load(std::memory_order_acquire) ? (T*)pthread_getspecific(self.key) : nullptr;
+				if (object == nullptr) {
+					object = new T;
+					object->AddRef();
+					std::unique_lock<std::mutex> sync(self.lock);
+					if (!self.keyed.load(std::memory_order_relaxed)) {
+						/* Without a key the object is simply not cached */
+						if (pthread_key_create(&self.key, &Exit) != 0) return object;
+						self.keyed.store(true, std::memory_order_release);
+					}
+					if (pthread_setspecific(self.key, object) != 0) return object;
+					self.objects.push_back(object);
+				}
+				object->AddRef();
+				return object;
+			}
+			static inline long Idle() {
+				auto&& self = Instance();
+				std::unique_lock<std::mutex> sync(self.lock);
+				return std::count_if(self.objects.begin(), self.objects.end(), [](T* object) { return object->References() == 1; });
+			}
+			static inline void Teardown() {
+				auto&& self = Instance();
+				std::vector<T*> released;
+				{
+					std::unique_lock<std::mutex> sync(self.lock);
+					if (self.keyed.exchange(false)) pthread_key_delete(self.key);
+					released.swap(self.objects);
+				}
+				for (auto object : released) object->Release();
+			}
+		};
+
+		/* Slots filled on first use; a racing creator loses the CAS and drops its object */
+		template<typename T, size_t SIZE>
+		class Activator<T, Activation::Pooled<SIZE>> {
+			static_assert(SIZE > 0, "Pooled activation needs at least one object");
+			std::atomic<T*>		slots[SIZE];
+
+			Activator() : slots() { ; }
+			static inline Activator& Instance() { static Activator activator; return activator; }
+		public:
+			static inline T* Acquire() {
+				auto&& slot = Instance().slots[ThreadSlot() % SIZE];
+				T* object = slot.load(std::memory_order_acquire);
+				if (object == nullptr) {
+					T* fresh = new T;
+					fresh->AddRef();
+					if (slot.compare_exchange_strong(object, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) object = fresh;
+					else fresh->Release();
+				}
+				object->AddRef();
+				return object;
+			}
+			static inline long Idle() {
+				long idle = 0;
+				for (auto&& slot : Instance().slots) { T* object = slot.load(std::memory_order_acquire); if (object != nullptr && object->References() == 1) idle++; }
+				return idle;
+			}
+			static inline void Teardown() {
+				for (auto&& slot : Instance().slots) { if (T* object = slot.exchange(nullptr, std::memory_order_acq_rel)) object->Release(); }
+			}
 		};
+
+		/* Descriptor entry of a server class */
+		template<typename T>
+		static inline constexpr ServerDescriptor::Class Describe() {
+			using Policy = typename ActivationOf<T>::type;
+			return { T::guid().c_str(), T::InterfaceIds, T::InterfaceCount,
+				Policy::Model | (std::is_void<typename PoolOf<T>::type>::value ? 0u : (uint32_t)ServerDescriptor::PooledMemory), Policy::Slots, sizeof(T) };
+		}
+
 		template<typename ... CLASSLIST>
 		class ClassRegistry {
+			static_assert(UniqueIds({ CLASSLIST::guid().hash()... }), "CLSID hash collision between server classes");
 		private:
+			/* New or cached object, see Activation */
 			template<typename T>
 			static inline bool CreateObject(const clsuid& iid, void **ppv) {
-				T *cls = new T;
+				T *cls = Activator<T>::Acquire();
 				if (cls != nullptr) {
-					if (cls->QueryInterface(iid, ppv)) {
-						return true;
-					}
-					delete cls;
+					if (cls->QueryInterface(iid, ppv)) return true;
+					cls->Release();
 				}
 				return false;
 			}
-			std::atomic_long															RegistryRefsCounter;
-			std::unordered_map<clsuid, std::function<bool(const clsuid& iid, void **ppv)>, Dom::GUID::Hash, Dom::GUID::Equal>	RegistryExports;
+			/* Stops at the first failure, returns how many of `ppv` were filled */
+			template<typename T>
+			static inline size_t CreateObjects(const clsuid& iid, size_t count, void **ppv) {
+				size_t n = 0;
+				for (; n < count && CreateObject<T>(iid, ppv + n); n++) { ; }
+				return n;
+			}
+			struct Export {
+				bool(*Create)(const clsuid& iid, void **ppv);
+				size_t(*CreateBatch)(const clsuid& iid, size_t count, void **ppv);
+			};
+			std::mutex																	RegistryCountersLock;
+			std::vector<std::pair<clsuid, std::unique_ptr<ShardedCounter>>>				RegistryCounters;
+			std::unordered_map<clsuid, Export, Dom::GUID::Hash, Dom::GUID::Equal>		RegistryExports;
+			HostAllocator																RegistryAllocator;
 		public:
-			ClassRegistry() : RegistryRefsCounter(0), RegistryExports({ std::make_pair(CLASSLIST::guid(),&CreateObject<CLASSLIST>)... }) { DOM_CALL_TRACE(""); }
+			ClassRegistry() : RegistryExports({ std::make_pair(CLASSLIST::guid(), Export{ &CreateObject<CLASSLIST>, &CreateObjects<CLASSLIST> })... }) { DOM_CALL_TRACE(""); }
 			virtual ~ClassRegistry() { DOM_CALL_TRACE(""); }
-			inline bool CreateInstance(const clsuid& iid, void **ppv) const { DOM_CALL_TRACE(""); *ppv = nullptr; auto&& it = RegistryExports.find(iid); return it != RegistryExports.end() && it->second(IUnknown::guid(), ppv); }
+			inline bool CreateInstance(const clsuid& iid, void **ppv) const { DOM_CALL_TRACE(""); *ppv = nullptr; auto&& it = RegistryExports.find(iid); return it != RegistryExports.end() && it->second.Create(IUnknown::guid(), ppv); }
+			/* One lookup for the whole batch; pooled classes take their blocks from the thread magazine */
+			inline size_t CreateInstances(const clsuid& iid, size_t count, void **ppv) const {
+				DOM_CALL_TRACE("%zu", count);
+				std::fill(ppv, ppv + count, nullptr);
+				auto&& it = RegistryExports.find(iid);
+				return it != RegistryExports.end() ? it->second.CreateBatch(IUnknown::guid(), count, ppv) : 0;
+			}
 
-			inline bool RegisterServer(IUnknown* unknown, std::string&& ns) const { DOM_CALL_TRACE(""); Interface<IRegistry> registry(unknown); if (registry) { for (auto&& it : RegistryExports) { if (!registry->RegisterClass(it.first, std::move(ns))) return false; } return true; } return false; }
-			inline bool UnRegisterServer(IUnknown* unknown, std::string&& ns) const { DOM_CALL_TRACE(""); Interface<IRegistry> registry(unknown); if (registry) { for (auto&& it : RegistryExports) { if (!registry->UnRegisterClass(it.first, std::move(ns))) return false; } return true; } return false; }
+			/* Class part of the server descriptor, in CLASSLIST order */
+			static constexpr uint32_t ClassCount = sizeof...(CLASSLIST);
+			static constexpr ServerDescriptor::Class Classes[] = { Describe<CLASSLIST>()... };
 
-			inline long IncrementRef() { DOM_CALL_TRACE("%ld", (long)RegistryRefsCounter + 1); return ++RegistryRefsCounter; }
-			inline long DecrementRef() { DOM_CALL_TRACE("%ld", (long)RegistryRefsCounter - 1); return --RegistryRefsCounter; }
+			/* Publishes every class with its own factory, see DOM_STATIC_SERVER */
+			inline void Link(const LinkedServer& server) const { LinkedServers::Instance().Link({ LinkedClass{ CLASSLIST::guid(), &CreateObject<CLASSLIST>, &CreateObjects<CLASSLIST>, &server }... }); }
 
-			inline virtual bool CanUnloadNow() { DOM_CALL_TRACE("%s (%ld)", RegistryRefsCounter == 0 ? "yes" : "no", (long)RegistryRefsCounter); return RegistryRefsCounter == 0; }
+			inline bool RegisterServer(IUnknown* unknown, std::string&& ns) const { DOM_CALL_TRACE(""); InterfaceRef<IRegistry> registry(unknown); if (registry) { for (auto&& it : RegistryExports) { if (!registry->RegisterClass(it.first, std::move(ns))) return false; } return true; } return false; }
+			inline bool UnRegisterServer(IUnknown* unknown, std::string&& ns) const { DOM_CALL_TRACE(""); InterfaceRef<IRegistry> registry(unknown); if (registry) { for (auto&& it : RegistryExports) { if (!registry->UnRegisterClass(it.first, std::move(ns))) return false; } return true; } return false; }
+
+			/* Objects alive in the module are counted per class and per thread; only CanUnloadNow and statistics need the totals */
+			inline ShardedCounter* ClassCounter(const clsuid& cid) {
+				std::unique_lock<std::mutex> sync(RegistryCountersLock);
+				for (auto&& it : RegistryCounters) { if (it.first == cid) return it.second.get(); }
+				RegistryCounters.emplace_back(cid, std::unique_ptr<ShardedCounter>(new ShardedCounter()));
+				return RegistryCounters.back().second.get();
+			}
+			/* -1 for a class this module does not know */
+			inline long InstanceCount(const clsuid& cid) {
+				std::unique_lock<std::mutex> sync(RegistryCountersLock);
+				for (auto&& it : RegistryCounters) { if (it.first == cid) return it.second->Sum(); }
+				return RegistryExports.count(cid) ? 0 : -1;
+			}
+
+			/* Pooled memory and cached objects only the activation caches hold never pin the module: once nothing else is alive
+			   the pools are trimmed, DllFinalize drops the caches */
+			inline virtual bool CanUnloadNow() {
+				long refs = -IdleObjects();
+				{
+					std::unique_lock<std::mutex> sync(RegistryCountersLock);
+					for (auto&& it : RegistryCounters) { refs += it.second->Sum(); }
+				}
+				DOM_CALL_TRACE("%s (%ld)", refs == 0 ? "yes" : "no", refs);
+				if (refs == 0) { TrimPools(); return true; }
+				return false;
+			}
+			static inline void TrimPools() { (void)std::initializer_list<int>{ (Pooling<CLASSLIST>::Trim(), 0)... }; }
+			static inline long IdleObjects() { long idle = 0; (void)std::initializer_list<int>{ (idle += Activator<CLASSLIST>::Idle(), 0)... }; return idle; }
+			static inline void TeardownActivators() { (void)std::initializer_list<int>{ (Activator<CLASSLIST>::Teardown(), 0)... }; }
 
 			inline virtual bool InstallServer(IUnknown* unknown) const { DOM_CALL_TRACE(""); return true; }
 			inline virtual bool UnInstallServer(IUnknown* unknown) const { DOM_CALL_TRACE(""); return true; }
 
-			inline virtual bool Initialize(IUnknown* unknown) const { DOM_CALL_TRACE(""); return true; }
-			inline virtual bool Finalize(IUnknown* unknown) const { DOM_CALL_TRACE(""); return true; }
+			inline HostAllocator* Allocator() { return &RegistryAllocator; }
+
+			/* Adopts the host IAllocator, if the host offers one, unless objects were already allocated */
+			inline virtual bool Initialize(IUnknown* unknown) {
+				DOM_CALL_TRACE("");
+				IAllocator* host = nullptr;
+				if (unknown != nullptr && unknown->QueryInterface(IAllocator::guid(), (void**)&host) && host != nullptr && !RegistryAllocator.Adopt(host)) {
+					DOM_ERR("Host allocator ignored, objects of this server are already allocated elsewhere");
+				}
+				return true;
+			}
+			inline virtual bool Finalize(IUnknown* unknown) const { DOM_CALL_TRACE(""); TeardownActivators(); TrimPools(); return true; }
 		};
 	}
 }
 
+#ifdef DOM_STATIC_SERVER
+/* Same server source linked into the executable: no exported symbols, the registry is published to Dom::LinkedServers
+   and managers resolve its classes before any registry, with direct calls to the class factories */
+#define DOM_SERVER_EXPORT(CLASS_REGISTRY,...)\
+	static CLASS_REGISTRY<__VA_ARGS__>	DllClassServerManager;\
+	static const Dom::LinkedServer DllLinkedServer = { "linked:" __FILE__,\
+		[](const Dom::clsuid& iid, void** ppv) { return DllClassServerManager.CreateInstance(iid,ppv); },\
+		[](const Dom::clsuid& iid, size_t count, void** ppv) { return DllClassServerManager.CreateInstances(iid,count,ppv); },\
+		[]() { return DllClassServerManager.CanUnloadNow(); },\
+		[](const Dom::clsuid& iid) { return DllClassServerManager.InstanceCount(iid); },\
+		[](Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.RegisterServer(unknown,std::move(ns)); },\
+		[](Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.UnRegisterServer(unknown,std::move(ns)); },\
+		[](Dom::IUnknown* unknown) { return DllClassServerManager.InstallServer(unknown); },\
+		[](Dom::IUnknown* unknown) { return DllClassServerManager.UnInstallServer(unknown); },\
+		[](Dom::IUnknown* unknown) { return DllClassServerManager.Initialize(unknown); },\
+		[](Dom::IUnknown* unknown) { return DllClassServerManager.Finalize(unknown); },\
+		[](const Dom::clsuid& cid) { return DllClassServerManager.ClassCounter(cid); },\
+		[]() { return DllClassServerManager.Allocator(); } };\
+	static const bool DllLinked = (DllClassServerManager.Link(DllLinkedServer), true);
+#else
 #define DOM_SERVER_EXPORT(CLASS_REGISTRY,...)\
 	static CLASS_REGISTRY<__VA_ARGS__>	DllClassServerManager;\
 	extern "C" {\
 		bool DllCreateInstance(Dom::clsuid& iid, void** ppv) {	return DllClassServerManager.CreateInstance(iid,ppv); }\
+		size_t DllCreateInstanceBatch(Dom::clsuid& iid, size_t count, void** ppv) { return DllClassServerManager.CreateInstances(iid,count,ppv); }\
 		bool DllCanUnloadNow() { return DllClassServerManager.CanUnloadNow(); } \
+		long DllInstanceCount(Dom::clsuid& iid) { return DllClassServerManager.InstanceCount(iid); } \
 		bool DllRegisterServer(Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.RegisterServer(unknown,std::move(ns)); } \
 		bool DllUnRegisterServer(Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.UnRegisterServer(unknown,std::move(ns)); }\
 		bool DllInstallServer(Dom::IUnknown* unknown) { return DllClassServerManager.InstallServer(unknown); } \
 		bool DllUnInstallServer(Dom::IUnknown* unknown) { return DllClassServerManager.UnInstallServer(unknown); }\
 		bool DllInitialize(Dom::IUnknown* unknown) { return DllClassServerManager.Initialize(unknown); } \
 		bool DllFinalize(Dom::IUnknown* unknown) { return DllClassServerManager.Finalize(unknown); }\
+		void DllAttachTrace(Dom::Trace::Tracer* tracer) { Dom::Trace::Tracer::Attach(tracer); }\
+		const Dom::ServerDescriptor* DllGetServerDescriptor() {\
+			static const Dom::ServerDescriptor descriptor = { Dom::ServerDescriptor::Version, DllClassServerManager.ClassCount, DllClassServerManager.Classes,\
+				[](const Dom::clsuid& iid, void** ppv) { return DllClassServerManager.CreateInstance(iid,ppv); },\
+				[](const Dom::clsuid& iid, size_t count, void** ppv) { return DllClassServerManager.CreateInstances(iid,count,ppv); },\
+				[]() { return DllClassServerManager.CanUnloadNow(); },\
+				[](const Dom::clsuid& iid) { return DllClassServerManager.InstanceCount(iid); },\
+				[](Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.RegisterServer(unknown,std::move(ns)); },\
+				[](Dom::IUnknown* unknown, std::string&& ns) { return DllClassServerManager.UnRegisterServer(unknown,std::move(ns)); },\
+				[](Dom::IUnknown* unknown) { return DllClassServerManager.InstallServer(unknown); },\
+				[](Dom::IUnknown* unknown) { return DllClassServerManager.UnInstallServer(unknown); },\
+				[](Dom::IUnknown* unknown) { return DllClassServerManager.Initialize(unknown); },\
+				[](Dom::IUnknown* unknown) { return DllClassServerManager.Finalize(unknown); },\
+				[](Dom::Trace::Tracer* tracer) { Dom::Trace::Tracer::Attach(tracer); } };\
+			return &descriptor;\
+		}\
 	};\
 	namespace Dom {\
 		namespace Server{\
-			long DllRefIncrement(){ return DllClassServerManager.IncrementRef();}\
-			long DllRefDecrement(){ return DllClassServerManager.DecrementRef();}\
+			ShardedCounter* DllClassCounter(const clsuid& cid){ return DllClassServerManager.ClassCounter(cid);}\
+			HostAllocator* DllClassAllocator(const clsuid&){ return DllClassServerManager.Allocator();}\
 		}}
+#endif // DOM_STATIC_SERVER
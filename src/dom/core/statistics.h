@@ -0,0 +1,103 @@
+#pragma once
+#include "../IStatistics.h"
+#include "sync.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+
+namespace Dom {
+	namespace Client {
+
+		/* Create counters of one (class, scope) binding, allocated by the first create after statistics are enabled */
+		struct ClassCounters {
+			std::atomic<uint64_t>	Creates;
+			std::atomic<uint64_t>	Failures;
+		};
+		using ClassStatistics = Sharded<ClassCounters>;
+
+		/* Manager-wide counters. Every update is a relaxed add on the calling thread's shard; disabled costs one load per call */
+		class Statistics {
+			struct Latency {
+				std::atomic<uint64_t>	Count[IStatistics::Histogram::Buckets];
+				std::atomic<uint64_t>	Sum;
+			};
+			std::atomic_bool					enabled;
+			Sharded<Latency>					latency;
+			Sharded<std::atomic<uint64_t>>		missing;
+			/* Updated by the lock holder only, atomics just keep snapshots well defined */
+			std::atomic<uint64_t>				lockAcquired, lockWait, lockMaxWait, lockHold, lockPublish;
+		public:
+#ifdef DOM_STATISTICS
+			static constexpr bool Default = true;
+#else
+			static constexpr bool Default = false;
+#endif // DOM_STATISTICS
+			static inline uint64_t Now() { return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+			Statistics(bool enable) : enabled(enable), latency(), missing(), lockAcquired(0), lockWait(0), lockMaxWait(0), lockHold(0), lockPublish(0) { ; }
+			Statistics(const Statistics&) = delete;
+
+			inline bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+			/* Returns the previous state */
+			inline bool Enable(bool enable) { return enabled.exchange(enable); }
+
+			/* Start of a measured call, 0 while disabled */
+			inline uint64_t Start() const { return Enabled() ? Now() : 0; }
+
+			inline void Created(uint64_t start) {
+				if (start == 0) return;
+				uint64_t ns = Now() - start;
+				size_t bucket = std::min<size_t>(ns ? 64 - __builtin_clzll(ns) : 0, IStatistics::Histogram::Buckets - 1);
+				auto&& local = latency.Local();
+				local.Count[bucket].fetch_add(1, std::memory_order_relaxed);
+				local.Sum.fetch_add(ns, std::memory_order_relaxed);
+			}
+			inline void NotFound() { if (Enabled()) missing.Local().fetch_add(1, std::memory_order_relaxed); }
+
+			inline void Locked(uint64_t wait, uint64_t hold) {
+				lockAcquired.fetch_add(1, std::memory_order_relaxed);
+				lockWait.fetch_add(wait, std::memory_order_relaxed);
+				lockHold.fetch_add(hold, std::memory_order_relaxed);
+				if (wait > lockMaxWait.load(std::memory_order_relaxed)) lockMaxWait.store(wait, std::memory_order_relaxed);
+			}
+			inline void Published(uint64_t ns) { lockPublish.fetch_add(ns, std::memory_order_relaxed); }
+
+			/* Everything but the per class, scope and server parts */
+			inline void Fill(IStatistics::Snapshot& snapshot) const {
+				auto&& histogram = snapshot.CreateLatency;
+				histogram = IStatistics::Histogram();
+				latency.ForEach([&](const Latency& local) {
+					for (size_t n = 0; n < IStatistics::Histogram::Buckets; n++) {
+						auto count = local.Count[n].load(std::memory_order_relaxed);
+						histogram.Count[n] += count;
+						histogram.Total += count;
+					}
+					histogram.SumNanos += local.Sum.load(std::memory_order_relaxed);
+				});
+				snapshot.NotFound = 0;
+				missing.ForEach([&](const std::atomic<uint64_t>& local) { snapshot.NotFound += local.load(std::memory_order_relaxed); });
+				snapshot.ListLock = { lockAcquired.load(std::memory_order_relaxed), lockWait.load(std::memory_order_relaxed), lockMaxWait.load(std::memory_order_relaxed),
+					lockHold.load(std::memory_order_relaxed), lockPublish.load(std::memory_order_relaxed) };
+			}
+		};
+
+		/* std::unique_lock that reports its wait and hold time while statistics are enabled */
+		class TimedLock {
+			Statistics&						stats;
+			uint64_t						requested, acquired;
+			std::unique_lock<std::mutex>	lock;
+		public:
+			TimedLock(std::mutex& mutex, Statistics& statistics) : stats(statistics), requested(statistics.Start()), acquired(0), lock(mutex) { acquired = requested ? Statistics::Now() : 0; }
+			TimedLock(const TimedLock&) = delete;
+			~TimedLock() { unlock(); }
+
+			inline void unlock() {
+				if (lock.owns_lock()) {
+					lock.unlock();
+					if (acquired) stats.Locked(acquired - requested, Statistics::Now() - acquired);
+				}
+			}
+		};
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <type_traits>
+
+namespace Dom {
+
+	/* Stable per-thread index, used to spread threads over cache-line padded shards */
+	static inline size_t ThreadSlot() {
+		static std::atomic_size_t next(0);
+		static thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+		return slot;
+	}
+
+	/* Counter split over cache-line padded per-thread shards: updates never contend, reading sums every shard.
+	   The sum is exact only while no update is in flight */
+	class ShardedCounter {
+		static constexpr size_t Shards = 64;
+		struct alignas(64) Shard {
+			std::atomic_long	value;
+		};
+		Shard	shards[Shards];
+	public:
+		ShardedCounter() : shards() { ; }
+		ShardedCounter(const ShardedCounter&) = delete;
+
+		inline void Add(long delta) { shards[ThreadSlot() % Shards].value.fetch_add(delta, std::memory_order_release); }
+		inline long Sum() const {
+			long sum = 0;
+			for (auto&& shard : shards) sum += shard.value.load(std::memory_order_acquire);
+			return sum;
+		}
+	};
+
+	/* Per-thread copies of SLOT (typically a struct of relaxed atomics), each on its own cache line; readers visit every shard */
+	template<typename SLOT, size_t SHARDS = 16>
+	class Sharded {
+		struct alignas(64) Shard {
+			SLOT	slot;
+		};
+		Shard	shards[SHARDS];
+	public:
+		Sharded() : shards() { ; }
+		Sharded(const Sharded&) = delete;
+
+		inline SLOT& Local() { return shards[ThreadSlot() % SHARDS].slot; }
+		template<typename FN>
+		inline void ForEach(FN&& fn) const { for (auto&& shard : shards) fn(shard.slot); }
+	};
+
+	/* Reference counting policies, selected by the class with `using refcount_policy = Dom::RefCount::...;` */
+	namespace RefCount {
+		/* Object never leaves its thread: plain load and store, no read-modify-write */
+		struct Single {
+			static inline long Increment(std::atomic_long& refs) { long n = refs.load(std::memory_order_relaxed) + 1; refs.store(n, std::memory_order_relaxed); return n; }
+			static inline long Decrement(std::atomic_long& refs) { long n = refs.load(std::memory_order_relaxed) - 1; refs.store(n, std::memory_order_relaxed); return n; }
+		};
+		/* Shared object: taking a reference needs no ordering, dropping one publishes our writes to whoever deletes */
+		struct Relaxed {
+			static inline long Increment(std::atomic_long& refs) { return refs.fetch_add(1, std::memory_order_relaxed) + 1; }
+			static inline long Decrement(std::atomic_long& refs) {
+				long n = refs.fetch_sub(1, std::memory_order_release) - 1;
+				if (n == 0) std::atomic_thread_fence(std::memory_order_acquire);
+				return n;
+			}
+		};
+		/* Sequentially consistent, the default */
+		struct Strict {
+			static inline long Increment(std::atomic_long& refs) { return ++refs; }
+			static inline long Decrement(std::atomic_long& refs) { return --refs; }
+		};
+	}
+
+	template<typename T, typename = void>
+	struct RefCountOf { using type = RefCount::Strict; };
+	template<typename T>
+	struct RefCountOf<T, std::void_t<typename T::refcount_policy>> { using type = typename T::refcount_policy; };
+
+	/* Read-mostly pointer publication. Readers enter on a per-thread shard and never block; writers (serialized by the caller)
+	   swap the pointer and wait two grace periods before the previous version may be released */
+	template<typename T>
+	class Rcu {
+		static constexpr size_t Shards = 64;
+		struct alignas(64) Shard {
+			std::atomic_long	readers[2];
+		};
+		std::atomic<T*>			current;
+		std::atomic_uint		phase;
+		Shard					shards[Shards];
+
+		inline void Drain(unsigned idx) {
+			for (auto&& shard : shards) {
+				while (shard.readers[idx].load(std::memory_order_acquire) != 0) { std::this_thread::yield(); }
+			}
+		}
+	public:
+		class Guard {
+			std::atomic_long*	counter;
+			T*					ptr;
+		public:
+			Guard(std::atomic_long* c, T* p) : counter(c), ptr(p) { ; }
+			Guard(const Guard&) = delete;
+			Guard(Guard&& g) : counter(g.counter), ptr(g.ptr) { g.counter = nullptr; }
+			~Guard() { if (counter != nullptr) counter->fetch_sub(1, std::memory_order_release); }
+			Guard& operator = (const Guard&) = delete;
+			inline T* operator -> () const { return ptr; }
+			inline T& operator * () const { return *ptr; }
+			inline T* get() const { return ptr; }
+		};
+
+		Rcu(T* initial = nullptr) : current(initial), phase(0), shards() { ; }
+		Rcu(const Rcu&) = delete;
+
+		inline Guard Read() {
+			auto&& counter = shards[ThreadSlot() % Shards].readers[phase.load() & 1];
+			counter.fetch_add(1);
+			return Guard(&counter, current.load());
+		}
+
+		/* Writer side: not synchronized against other writers */
+		inline T* Peek() const { return current.load(std::memory_order_acquire); }
+
+		/* Publish a new version; returns the previous one once no reader can observe it any more */
+		inline T* Publish(T* next) {
+			T* prev = current.exchange(next);
+			unsigned idx = phase.load();
+			for (int round = 0; round < 2; round++) {
+				phase.store(idx ^ 1);
+				Drain(idx & 1);
+				idx ^= 1;
+			}
+			return prev;
+		}
+	};
+}
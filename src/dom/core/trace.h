@@ -0,0 +1,221 @@
+#pragma once
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <initializer_list>
+
+namespace Dom {
+	namespace Trace {
+
+		enum Level : uint32_t { Call = 0, Error = 1 };
+
+		/* Call site, constant initialized: nothing about the function name is computed at run time.
+		   Strings are copied into the tracer on the first event, so sites of unloaded servers stay decodable */
+		struct Tracer;
+		struct Site {
+			const char*				function;
+			const char*				format;
+			const char*				file;
+			uint32_t				line;
+			Level					level;
+			std::atomic<Tracer*>	owner;
+			std::atomic<uint32_t>	id;
+
+			constexpr Site(Level l, const char* fn, const char* fmt, const char* f, uint32_t ln) : function(fn), format(fmt), file(f), line(ln), level(l), owner(nullptr), id(0) { ; }
+		};
+
+		/* Fixed-size binary record; arguments are packed in order, their kinds are 4-bit tags in `types` */
+		struct Record {
+			enum Kind : uint32_t { End = 0, Int = 1, UInt = 2, Double = 3, String = 4, Pointer = 5 };
+			static constexpr size_t Args = 8;
+			static constexpr size_t Payload = 104;
+
+			std::atomic<uint64_t>	seq;
+			uint64_t				stamp;
+			uint32_t				site;
+			uint32_t				types;
+			uint8_t					payload[Payload];
+		};
+		static_assert(sizeof(Record) == 128, "trace record layout");
+
+		/* Single-writer ring, owned by one thread; the dump copies it with a per-record sequence check */
+		struct Ring {
+			Tracer*					owner;
+			uint32_t				thread;
+			uint32_t				mask;
+			std::atomic<uint64_t>	head;
+			Record*					records;
+		};
+
+		/*
+			Dump file: "DOMTRACE", version, counts, then sites (line, level, function, format, file as length-prefixed strings)
+			and for every ring its thread id and the valid records oldest first. Decoded by tools/tracedecode.cpp
+		*/
+		struct Tracer {
+			static constexpr uint32_t Version = 1;
+		private:
+			struct SiteInfo {
+				uint32_t	line;
+				Level		level;
+				std::string	function, format, file;
+			};
+			std::atomic_bool		enabled;
+			std::atomic<uint32_t>	capacity;
+			std::mutex				lock;
+			std::vector<SiteInfo>	listSites;
+			std::vector<Ring*>		listRings;
+
+			static inline std::atomic<Tracer*>& Slot() { static std::atomic<Tracer*> slot(nullptr); return slot; }
+			/* Rings are never freed: a dump may still read them after the thread exits */
+			static inline Ring*& Local() { static thread_local Ring* ring = nullptr; return ring; }
+
+			inline Ring* NewRing() {
+				auto ring = new Ring();
+				uint32_t size = capacity.load(std::memory_order_relaxed);
+				ring->owner = this;
+				ring->thread = (uint32_t)syscall(SYS_gettid);
+				ring->mask = size - 1;
+				ring->head = 0;
+				ring->records = new Record[size]();
+				std::unique_lock<std::mutex> sync(lock);
+				listRings.push_back(ring);
+				return ring;
+			}
+			inline void Register(Site& site) {
+				std::unique_lock<std::mutex> sync(lock);
+				if (site.owner.load(std::memory_order_relaxed) == this) return;
+				site.id.store((uint32_t)listSites.size(), std::memory_order_relaxed);
+				listSites.push_back({ site.line, site.level, site.function, site.format, site.file });
+				site.owner.store(this, std::memory_order_release);
+			}
+
+			static inline void Put(Record& r, size_t& at, size_t& n, Record::Kind kind, const void* value, size_t length) {
+				if (n >= Record::Args || at + length > Record::Payload) return;
+				std::memcpy(r.payload + at, value, length);
+				r.types |= (uint32_t)kind << (4 * n++);
+				at += length;
+			}
+			static inline void Put(Record& r, size_t& at, size_t& n, const char* value) {
+				if (n >= Record::Args || at >= Record::Payload) return;
+				size_t length = value != nullptr ? std::min<size_t>({ std::strlen(value), Record::Payload - at - 1, 255 }) : 0;
+				r.payload[at] = (uint8_t)length;
+				std::memcpy(r.payload + at + 1, value, length);
+				r.types |= (uint32_t)Record::String << (4 * n++);
+				at += length + 1;
+			}
+			template<typename A>
+			static inline void Pack(Record& r, size_t& at, size_t& n, const A& value) {
+				using T = typename std::decay<A>::type;
+				if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) { Put(r, at, n, value); }
+				else if constexpr (std::is_floating_point<T>::value) { double v = (double)value; Put(r, at, n, Record::Double, &v, sizeof(v)); }
+				else if constexpr (std::is_pointer<T>::value) { uint64_t v = (uint64_t)(uintptr_t)value; Put(r, at, n, Record::Pointer, &v, sizeof(v)); }
+				else if constexpr (std::is_signed<T>::value) { int64_t v = (int64_t)value; Put(r, at, n, Record::Int, &v, sizeof(v)); }
+				else { uint64_t v = (uint64_t)value; Put(r, at, n, Record::UInt, &v, sizeof(v)); }
+			}
+			static inline void Pack(Record& r, size_t& at, size_t& n, const std::string& value) { Put(r, at, n, value.c_str()); }
+		public:
+			Tracer() : enabled(false), capacity(2048) { ; }
+			Tracer(const Tracer&) = delete;
+
+			/* Process tracer. Servers trace into their own until the client attaches its tracer on load */
+			static inline Tracer* Current() {
+				auto tracer = Slot().load(std::memory_order_acquire);
+				if (tracer == nullptr) {
+					auto fresh = new Tracer();
+					if (Slot().compare_exchange_strong(tracer, fresh)) tracer = fresh; else delete fresh;
+				}
+				return tracer;
+			}
+			/* Without creating one: nothing is traced until someone asks for the tracer to enable it */
+			static inline Tracer* Active() { return Slot().load(std::memory_order_acquire); }
+			static inline void Attach(Tracer* tracer) { if (tracer != nullptr) Slot().store(tracer, std::memory_order_release); }
+
+			inline bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+			/* `records` per thread, rounded up to a power of two; applies to rings created afterwards */
+			inline void Enable(bool enable = true, uint32_t records = 2048) {
+				uint32_t size = 1;
+				while (size < records) size <<= 1;
+				capacity = size;
+				enabled = enable;
+			}
+
+			template<typename ... ARGS>
+			inline void Event(Site& site, const ARGS& ... args) {
+				if (site.owner.load(std::memory_order_acquire) != this) Register(site);
+				auto&& local = Local();
+				if (local == nullptr || local->owner != this) local = NewRing();
+
+				auto pos = local->head.load(std::memory_order_relaxed);
+				auto&& r = local->records[pos & local->mask];
+				r.seq.store(0, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				r.stamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+				r.site = site.id.load(std::memory_order_relaxed);
+				r.types = 0;
+				[[maybe_unused]] size_t at = 0, n = 0;
+				(void)std::initializer_list<int>{ (Pack(r, at, n, args), 0)... };
+				r.seq.store(pos + 1, std::memory_order_release);
+				local->head.store(pos + 1, std::memory_order_release);
+			}
+
+			/* Safe while tracing continues, records overwritten during the copy are dropped */
+			inline bool Dump(const std::string& path) {
+				std::vector<SiteInfo> sites;
+				std::vector<Ring*> rings;
+				{
+					std::unique_lock<std::mutex> sync(lock);
+					sites = listSites;
+					rings = listRings;
+				}
+				auto file = fopen(path.c_str(), "wb");
+				if (file == nullptr) return false;
+				auto Write = [&](const void* data, size_t length) { return fwrite(data, 1, length, file) == length; };
+				auto Text = [&](const std::string& text) { uint32_t length = (uint32_t)text.length(); return Write(&length, sizeof(length)) && Write(text.data(), length); };
+
+				uint32_t header[4] = { Version, (uint32_t)sites.size(), (uint32_t)rings.size(), (uint32_t)sizeof(Record) };
+				bool written = Write("DOMTRACE", 8) && Write(header, sizeof(header));
+				for (auto&& site : sites) {
+					uint32_t info[2] = { site.line, (uint32_t)site.level };
+					written = written && Write(info, sizeof(info)) && Text(site.function) && Text(site.format) && Text(site.file);
+				}
+				std::vector<Record> copy;
+				for (auto ring : rings) {
+					uint64_t head = ring->head.load(std::memory_order_acquire), size = ring->mask + 1, count = 0;
+					if (copy.size() < size) copy = std::vector<Record>(size);
+					for (uint64_t pos = head > size ? head - size : 0; pos < head; pos++) {
+						auto&& r = ring->records[pos & ring->mask];
+						if (r.seq.load(std::memory_order_acquire) != pos + 1) continue;
+						auto&& c = copy[count];
+						c.stamp = r.stamp; c.site = r.site; c.types = r.types;
+						std::memcpy(c.payload, r.payload, sizeof(c.payload));
+						std::atomic_thread_fence(std::memory_order_acquire);
+						if (r.seq.load(std::memory_order_relaxed) != pos + 1) continue;
+						c.seq.store(pos + 1, std::memory_order_relaxed);
+						count++;
+					}
+					uint32_t info[2] = { ring->thread, (uint32_t)count };
+					written = written && Write(info, sizeof(info)) && (count == 0 || Write(copy.data(), count * sizeof(Record)));
+				}
+				return fclose(file) == 0 && written;
+			}
+		};
+
+		template<typename ... ARGS>
+		static inline void Event(Site& site, const ARGS& ... args) {
+			auto tracer = Tracer::Active();
+			if (tracer != nullptr && tracer->Enabled()) tracer->Event(site, args...);
+		}
+	}
+}
+
+#define DOM_TRACE_EVENT(level, format, ...) \
+	do { static Dom::Trace::Site __dom_trace_site(level, __PRETTY_FUNCTION__, format, __FILE__, __LINE__); Dom::Trace::Event(__dom_trace_site, ##__VA_ARGS__); } while (0)
@@ -0,0 +1,126 @@
+#pragma once
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Dom {
+	namespace Client {
+
+		/* inotify watch over one or more registry trees, reports class symlinks added to or removed from a scope */
+		class RegistryWatcher {
+		public:
+			/* A removal without a Name is a scope directory that left the tree: every class linked under SoPathName goes */
+			struct Change {
+				bool		Added;
+				std::string	Name;
+				std::string	Scope;
+				std::string	SoPathName;
+			};
+		private:
+			static constexpr uint32_t Mask = IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE_SELF | IN_ONLYDIR;
+
+			int													fd;
+			/* watch descriptor -> (registry root, directory relative to it) */
+			std::unordered_map<int, std::pair<std::string, std::string>>	listWatches;
+
+			/* Watch a directory and report what is already inside: links may be created before the watch is in place */
+			inline bool WatchDir(const std::string& root, const std::string& dir, std::vector<Change>& changes) {
+				int wd = inotify_add_watch(fd, (root + dir).c_str(), Mask);
+				if (wd < 0) {
+					DOM_ERR("inotify_add_watch(%s%s) `%s`", root.c_str(), dir.c_str(), strerror(errno));
+					return false;
+				}
+				listWatches[wd] = std::make_pair(root, dir);
+				if (auto handle = opendir((root + dir).c_str())) {
+					while (auto f = readdir(handle)) {
+						if (f->d_name[0] == '.') continue;
+						auto type = f->d_type;
+						if (type == DT_UNKNOWN) {
+							struct stat info;
+							type = lstat((root + dir + f->d_name).c_str(), &info) != 0 ? DT_UNKNOWN : S_ISDIR(info.st_mode) ? DT_DIR : S_ISLNK(info.st_mode) ? DT_LNK : DT_REG;
+						}
+						if (type == DT_DIR) {
+							WatchDir(root, dir + f->d_name + '/', changes);
+						}
+						else if (type == DT_LNK) {
+							changes.push_back({ true, f->d_name, Scope(dir), root + dir + f->d_name });
+						}
+					}
+					closedir(handle);
+				}
+				return true;
+			}
+			/* Drops the watches of a directory gone from the tree, and of those below it: links made there later are none of ours */
+			inline void UnwatchDir(const std::string& root, const std::string& dir, std::vector<Change>& changes) {
+				for (auto&& it = listWatches.begin(); it != listWatches.end();) {
+					if (it->second.first == root && it->second.second.compare(0, dir.length(), dir) == 0) {
+						inotify_rm_watch(fd, it->first);
+						it = listWatches.erase(it);
+					}
+					else ++it;
+				}
+				changes.push_back({ false, std::string(), Scope(dir), root + dir });
+			}
+			static inline std::string Scope(const std::string& dir) { return dir.empty() ? dir : dir.substr(0, dir.length() - 1); }
+		public:
+			RegistryWatcher() : fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+				if (fd < 0) {
+					DOM_ERR("inotify_init1 `%s`", strerror(errno));
+				}
+			}
+			RegistryWatcher(const RegistryWatcher&) = delete;
+			~RegistryWatcher() { if (fd >= 0) close(fd); }
+
+			/* Pollable descriptor, readable whenever Read() has something to report */
+			inline int Descriptor() const { return fd; }
+
+			/* `root` must end with '/'; the current content of the tree is reported as added */
+			inline bool Watch(const std::string& root, std::vector<Change>& changes) {
+				return fd >= 0 && WatchDir(root, std::string(), changes);
+			}
+
+			/* Drains pending events without blocking; returns false if the kernel queue overflowed and a rescan is required */
+			inline bool Read(std::vector<Change>& changes) {
+				alignas(struct inotify_event) char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+				bool complete = true;
+				for (;;) {
+					auto length = read(fd, buffer, sizeof(buffer));
+					if (length <= 0) break;
+					for (char* ptr = buffer; ptr < buffer + length; ) {
+						auto e = (const struct inotify_event*)ptr;
+						ptr += sizeof(struct inotify_event) + e->len;
+
+						if (e->mask & IN_Q_OVERFLOW) { complete = false; continue; }
+						auto&& watch = listWatches.find(e->wd);
+						if (watch == listWatches.end()) continue;
+						if (e->mask & IN_IGNORED) { listWatches.erase(watch); continue; }
+						if (e->len == 0 || e->name[0] == '.') continue;
+
+						auto root = watch->second.first, dir = watch->second.second;
+						if (e->mask & IN_ISDIR) {
+							if (e->mask & (IN_CREATE | IN_MOVED_TO)) WatchDir(root, dir + e->name + '/', changes);
+							else if (e->mask & (IN_DELETE | IN_MOVED_FROM)) UnwatchDir(root, dir + e->name + '/', changes);
+						}
+						else if (e->mask & (IN_CREATE | IN_MOVED_TO)) {
+							struct stat info;
+							if (lstat((root + dir + e->name).c_str(), &info) == 0 && S_ISLNK(info.st_mode)) {
+								changes.push_back({ true, e->name, Scope(dir), root + dir + e->name });
+							}
+						}
+						else if (e->mask & (IN_DELETE | IN_MOVED_FROM)) {
+							changes.push_back({ false, e->name, Scope(dir), root + dir + e->name });
+						}
+					}
+				}
+				return complete;
+			}
+		};
+	}
+}
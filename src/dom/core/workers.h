@@ -0,0 +1,104 @@
+#pragma once
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <condition_variable>
+
+namespace Dom {
+
+	/* Fixed set of threads draining one FIFO of tasks, so bulk operations never spawn a thread per item */
+	class WorkerPool {
+		std::mutex								lock;
+		std::condition_variable					wake;
+		std::deque<std::function<void()>>		queue;
+		std::vector<std::thread>				workers;
+		bool									stop;
+
+		inline void Run() {
+			for (;;) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> sync(lock);
+					wake.wait(sync, [this]() { return stop || !queue.empty(); });
+					if (queue.empty()) return;
+					task = std::move(queue.front());
+					queue.pop_front();
+				}
+				task();
+			}
+		}
+
+		/* Progress of one ForEach, shared with helper tasks that may start after the caller returned */
+		struct Batch {
+			std::atomic_size_t		next;
+			size_t					count, done;
+			std::mutex				lock;
+			std::condition_variable	finished;
+			std::exception_ptr		error;
+
+			Batch(size_t n) : next(0), count(n), done(0) { ; }
+
+			template<typename FN>
+			inline void Drain(FN& fn) {
+				for (size_t n; (n = next.fetch_add(1, std::memory_order_relaxed)) < count; ) {
+					std::exception_ptr failure;
+					try { fn(n); }
+					catch (...) { failure = std::current_exception(); }
+					std::unique_lock<std::mutex> sync(lock);
+					if (failure && !error) error = failure;
+					if (++done == count) finished.notify_all();
+				}
+			}
+		};
+	public:
+		static inline size_t DefaultSize() { return std::max<size_t>(2, std::min<size_t>(16, std::thread::hardware_concurrency())); }
+
+		WorkerPool(size_t threads = DefaultSize()) : stop(false) {
+			for (size_t n = 0; n < std::max<size_t>(1, threads); n++) {
+				workers.emplace_back(&WorkerPool::Run, this);
+			}
+		}
+		WorkerPool(const WorkerPool&) = delete;
+		/* Queued tasks still run before the threads exit */
+		~WorkerPool() {
+			{
+				std::unique_lock<std::mutex> sync(lock);
+				stop = true;
+			}
+			wake.notify_all();
+			for (auto&& worker : workers) worker.join();
+		}
+
+		inline size_t Size() const { return workers.size(); }
+
+		inline void Submit(std::function<void()>&& task) {
+			{
+				std::unique_lock<std::mutex> sync(lock);
+				queue.emplace_back(std::move(task));
+			}
+			wake.notify_one();
+		}
+
+		/* fn(0) .. fn(count - 1) on the pool and the calling thread; returns once all are done and rethrows the first exception.
+		   The caller drains items too, so nested calls from a worker cannot deadlock */
+		template<typename FN>
+		inline void ForEach(size_t count, FN&& fn) {
+			if (count == 0) return;
+			auto batch = std::make_shared<Batch>(count);
+			auto call = &fn;
+			for (size_t n = 1; n < std::min(count, Size() + 1); n++) {
+				Submit([batch, call]() { batch->Drain(*call); });
+			}
+			batch->Drain(fn);
+			std::unique_lock<std::mutex> sync(batch->lock);
+			batch->finished.wait(sync, [&]() { return batch->done == batch->count; });
+			if (batch->error) std::rethrow_exception(batch->error);
+		}
+	};
+}
@@ -4,12 +4,12 @@
 	#define DOM_REGPATH "/var/local/dynamic-object-models/"
 #endif // !DOM_REGPATH
 
-#if !defined(NDEBUG) && defined(DOM_TRACE)
-	#include <regex>
-	const static std::regex __dom_re_fn(R"((.*?)(?:<.*?>)?(::~?\w+)\(.*)");
-	const static std::regex __dom_re_return(R"((?:[\w\s]+\s+)?(.*))");
-	#define DOM_ERR(format,...) fprintf(stderr,"[ ERROR::%s ] " format "\n", std::regex_replace(std::regex_replace(__PRETTY_FUNCTION__, __dom_re_fn, "$1$2"), __dom_re_return, "$1").c_str(), ##__VA_ARGS__)
-	#define DOM_CALL_TRACE(format,...) fprintf(stdout,"[ TRACE::%s ] " format "\n", std::regex_replace(std::regex_replace(__PRETTY_FUNCTION__, __dom_re_fn, "$1$2"), __dom_re_return, "$1").c_str(), ##__VA_ARGS__)
+#include "./core/trace.h"
+
+/* Binary trace records, decoded offline by tools/tracedecode.cpp; off until Dom::Trace::Tracer::Current()->Enable() */
+#if defined(DOM_TRACE)
+	#define DOM_ERR(format,...) DOM_TRACE_EVENT(Dom::Trace::Error, format, ##__VA_ARGS__)
+	#define DOM_CALL_TRACE(format,...) DOM_TRACE_EVENT(Dom::Trace::Call, format, ##__VA_ARGS__)
 #else
 #define DOM_ERR(format,...)
 #define DOM_CALL_TRACE(format,...)
@@ -1,22 +1,94 @@
 #pragma once
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <initializer_list>
 
 
 #define dom_guid_pre_name	"IID#"
 #define dom_cls_pre_name	"CLSID#"
 
 #define IID(name) \
-	inline static const Dom::uiid& guid() { const static Dom::GUID idn(dom_guid_pre_name #name); return idn; }
+	static constexpr Dom::GUID __guid = Dom::GUID(Dom::GUID::Static, dom_guid_pre_name #name);\
+	inline static constexpr const Dom::uiid& guid() { return __guid; }
 
 #define CLSID(name) \
-	inline static const Dom::clsuid& guid() { const static  Dom::GUID idn(dom_cls_pre_name #name); return idn; }
+	static constexpr Dom::GUID __guid = Dom::GUID(Dom::GUID::Static, dom_cls_pre_name #name);\
+	inline static constexpr const Dom::clsuid& guid() { return __guid; }
 
 namespace Dom {
 
+	/* FNV-1a 64, zero is reserved for the empty id */
+	static inline constexpr uint64_t GuidFold(const char* str, size_t len, uint64_t hash = 0xcbf29ce484222325ull) {
+		for (size_t i = 0; i < len; i++) { hash ^= (uint8_t)str[i]; hash *= 0x100000001b3ull; }
+		return hash;
+	}
+	static inline constexpr uint64_t GuidHash(const char* str, size_t len) { return len ? GuidFold(str, len) : 0; }
+	static inline constexpr size_t GuidLength(const char* str) {
+		size_t len = 0;
+		while (str != nullptr && str[len] != '\0') len++;
+		return len;
+	}
+
+	/* Process-wide, insert-only table of canonical id names. Readers never lock */
+	class GuidPool {
+	public:
+		struct Entry {
+			const Entry*	next;
+			uint64_t		hash;
+			size_t			length;
+			char			name[1];
+		};
+	private:
+		static constexpr size_t Buckets = 4096;
+		std::atomic<const Entry*>	pool[Buckets];
+
+		static inline bool Match(const Entry* e, uint64_t hash, const char* pre, size_t pl, const char* name, size_t nl) {
+			return e->hash == hash && e->length == pl + nl && std::memcmp(e->name, pre, pl) == 0 && std::memcmp(e->name + pl, name, nl) == 0;
+		}
+		static inline const Entry* Find(const Entry* e, const Entry* last, uint64_t hash, const char* pre, size_t pl, const char* name, size_t nl) {
+			for (; e != last; e = e->next) { if (Match(e, hash, pre, pl, name, nl)) return e; }
+			return nullptr;
+		}
+	public:
+		constexpr GuidPool() : pool{} { ; }
+
+		inline const Entry* Intern(uint64_t hash, const char* pre, size_t pl, const char* name, size_t nl) {
+			auto&& bucket = pool[hash & (Buckets - 1)];
+			const Entry* head = bucket.load(std::memory_order_acquire);
+			if (auto e = Find(head, nullptr, hash, pre, pl, name, nl)) return e;
+
+			Entry* entry = (Entry*)std::malloc(sizeof(Entry) + pl + nl);
+			if (entry == nullptr) throw std::bad_alloc();
+			entry->hash = hash; entry->length = pl + nl;
+			std::memcpy(entry->name, pre, pl); std::memcpy(entry->name + pl, name, nl); entry->name[pl + nl] = '\0';
+			entry->next = head;
+			while (!bucket.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_acquire)) {
+				/* Someone pushed in front of us, check whether it is our name */
+				if (auto e = Find(entry->next, head, hash, pre, pl, name, nl)) { std::free(entry); return e; }
+				head = entry->next;
+			}
+			return entry;
+		}
+
+		static inline GuidPool& Instance() { static GuidPool instance; return instance; }
+	};
+
 	class GUID {
+		uint64_t	hGUID;
+		const char*	sGUID;
 		size_t		sLength;
-		char*		sGUID;
+
+		inline void Intern(const char* pre, size_t pl, const char* name, size_t nl) {
+			if (pl + nl) {
+				hGUID = GuidFold(name, nl, GuidFold(pre, pl));
+				auto&& entry = GuidPool::Instance().Intern(hGUID, pre, pl, name, nl);
+				sGUID = entry->name; sLength = entry->length;
+			}
+		}
 	public:
 		struct Hash {
 			inline size_t operator()(const GUID& id) const { return id.hash(); }
@@ -24,22 +96,36 @@ namespace Dom {
 		struct Equal {
 			inline bool operator()(const GUID& l, const GUID& r) const { return l == r; }
 		};
+		enum Literal { Static };
 	public:
-		GUID(const char* vGUID = nullptr) : sLength(0), sGUID(nullptr) { if (vGUID != nullptr) { sLength = std::strlen(vGUID); sGUID = new char[sLength + 1]; sGUID[sLength] = '\0'; std::strncpy(sGUID, vGUID, sLength); } }
-		GUID(const GUID& v) : sLength(v.sLength), sGUID(nullptr) { if (v.sGUID != nullptr) { sGUID = new char[sLength + 1]; sGUID[sLength] = '\0'; std::strncpy(sGUID, v.sGUID, sLength); } }
-		GUID(const std::string vGUID) : sLength(vGUID.length()), sGUID(nullptr) { if (!vGUID.empty()) { sGUID = new char[sLength + 1]; sGUID[sLength] = '\0'; std::strncpy(sGUID, vGUID.data(), sLength); } }
-		~GUID() { if (sGUID != nullptr) { char* str = sGUID; sGUID = nullptr; sLength = 0; delete[] str; } }
-		inline bool operator == (const GUID& WithThis) const { return sGUID == WithThis.sGUID || (sLength == WithThis.sLength && std::strncmp(sGUID, WithThis.sGUID, sLength) == 0); }
-		inline size_t hash() const { return std::_Hash_impl::hash(sGUID, sLength); }
-		inline const char* c_str() const { return sGUID; }
-		inline size_t length() const { return sLength; }
-		inline bool empty() const { return !sLength; }
+		constexpr GUID() : hGUID(0), sGUID(nullptr), sLength(0) { ; }
+		constexpr GUID(Literal, const char* vGUID) : hGUID(GuidHash(vGUID, GuidLength(vGUID))), sGUID(vGUID), sLength(GuidLength(vGUID)) { ; }
+		GUID(const char* vGUID) : hGUID(0), sGUID(nullptr), sLength(0) { Intern("", 0, vGUID, GuidLength(vGUID)); }
+		GUID(const std::string& vGUID) : hGUID(0), sGUID(nullptr), sLength(0) { Intern("", 0, vGUID.data(), vGUID.length()); }
+		GUID(const char* vPrefix, const char* vGUID, size_t vLength) : hGUID(0), sGUID(nullptr), sLength(0) { Intern(vPrefix, GuidLength(vPrefix), vGUID, vLength); }
+		inline constexpr bool operator == (const GUID& WithThis) const { return sGUID == WithThis.sGUID || hGUID == WithThis.hGUID; }
+		inline constexpr bool operator != (const GUID& WithThis) const { return !(*this == WithThis); }
+		/* Same id but different name, i.e. a hash collision */
+		inline bool collides(const GUID& WithThis) const { return hGUID == WithThis.hGUID && (sLength != WithThis.sLength || std::strncmp(sGUID, WithThis.sGUID, sLength) != 0); }
+		inline constexpr size_t hash() const { return hGUID; }
+		inline constexpr const char* c_str() const { return sGUID; }
+		inline constexpr size_t length() const { return sLength; }
+		inline constexpr bool empty() const { return !sLength; }
 	};
 
 	using gid = GUID;
 	using uiid = gid;
 	using clsuid = gid;
 
-	static inline const gid ClsId(const std::string& class_name) { return GUID(std::string(dom_cls_pre_name) + class_name); }
-	static inline const gid IId(const std::string& interface_name) { return GUID(std::string(dom_guid_pre_name) + interface_name); }
+	static inline constexpr bool UniqueIds(std::initializer_list<uint64_t> ids) {
+		for (auto l = ids.begin(); l != ids.end(); l++) {
+			for (auto r = l + 1; r != ids.end(); r++) { if (*l == *r) return false; }
+		}
+		return true;
+	}
+
+	static inline const gid ClsId(const char* class_name) { return GUID(dom_cls_pre_name, class_name, GuidLength(class_name)); }
+	static inline const gid ClsId(const std::string& class_name) { return GUID(dom_cls_pre_name, class_name.data(), class_name.length()); }
+	static inline const gid IId(const char* interface_name) { return GUID(dom_guid_pre_name, interface_name, GuidLength(interface_name)); }
+	static inline const gid IId(const std::string& interface_name) { return GUID(dom_guid_pre_name, interface_name.data(), interface_name.length()); }
 }
@@ -1,10 +1,43 @@
-#ifndef DOM_SAMPLE
+#if !defined(DOM_SAMPLE) && !defined(DOM_BENCHMARK) && !defined(DOM_TRACE_DECODER)
 
 #include <cstdio>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <unordered_set>
+#include <climits>
+#include <unistd.h>
 #include "src/dom/dom.h"
 
 using namespace Dom;
 
+/* A failed check is reported and the run exits with the number of failures */
+static int Failures = 0;
+#define CHECK(condition) do { if (!(condition)) { fprintf(stderr, "%s:%d: check `%s` failed\n", __FILE__, __LINE__, #condition); Failures++; } } while (0)
+
+/* The sample server (skeleton/skel.cpp built with DOM_SAMPLE): DOM_SAMPLE_SO, otherwise lib-sample.so next to this executable */
+static inline std::string SamplePath() {
+#ifdef DOM_SAMPLE_SO
+	return DOM_SAMPLE_SO;
+#else
+	char exe[PATH_MAX];
+	auto len = readlink("/proc/self/exe", exe, sizeof(exe));
+	std::string path(exe, len > 0 ? len : 0);
+	return path.substr(0, path.rfind('/') + 1) + "lib-sample.so";
+#endif
+}
+static const std::string Sample(SamplePath());
+
+/* With DOM_STATIC_SERVER the linked sample wins over the module: checks on loading, sweeping and the module allocator do not apply */
+#ifdef DOM_STATIC_SERVER
+static constexpr bool Linked = true;
+#else
+static constexpr bool Linked = false;
+#endif
+
 struct IRegistry2 : public virtual IUnknown {
 	virtual bool RegisterClass2(const clsuid& /* class uid */, std::string&& /* Namespace */) = 0;
 	virtual bool UnRegisterClass2(const clsuid& /* class uid */, std::string&& /* Namespace */) = 0;
@@ -28,13 +61,65 @@ public:
 
 #include "skeleton/IHello.h"
 
-int main()
+/* Same class under each reference counting policy, see Case #6; every one counts its destructions */
+static long Destroyed = 0;
+struct StrictHello : public Dom::Client::Embedded<StrictHello, IHello> { virtual ~StrictHello() { Destroyed++; } virtual void Say() { ; } CLSID(StrictHello) };
+struct RelaxedHello : public Dom::Client::Embedded<RelaxedHello, IHello> { using refcount_policy = Dom::RefCount::Relaxed; virtual ~RelaxedHello() { Destroyed++; } virtual void Say() { ; } CLSID(RelaxedHello) };
+struct SingleHello : public Dom::Client::Embedded<SingleHello, IHello> { using refcount_policy = Dom::RefCount::Single; virtual ~SingleHello() { Destroyed++; } virtual void Say() { ; } CLSID(SingleHello) };
+
+/* Counts every reference operation, see Case #7 */
+struct CountedHello : public Dom::Client::Embedded<CountedHello, IHello> {
+	static long AddRefs, Releases;
+	virtual long AddRef() { AddRefs++; return Embedded::AddRef(); }
+	virtual long Release() { Releases++; return Embedded::Release(); }
+	virtual void Say() { ; }
+	CLSID(CountedHello)
+};
+long CountedHello::AddRefs = 0, CountedHello::Releases = 0;
+
+/* Factory hand-off: the caller receives the reference created here */
+static inline Interface<IHello> MakeCounted() {
+	Interface<IHello> hello;
+	Dom::IUnknown* unkn = *new CountedHello;
+	unkn->AddRef();
+	hello.Attach(unkn);
+	return hello;
+}
+static inline void SayBorrowed(InterfaceRef<IHello> hello) { hello->Say(); }
+
+/* Marshaling of the sample interfaces for the out-of-process server of Case #16; the host is this executable */
+#include "skeleton/IChecksum.h"
+
+DOM_REMOTE_INTERFACE(IHello, &IHello::Say)
+DOM_REMOTE_INTERFACE(IChecksum, &IChecksum::Sum)
+
+class ChecksumProxy : public Dom::Remote::Proxy<ChecksumProxy, IHello, IChecksum> {
+public:
+	using Proxy::Proxy;
+	virtual void Say() { Invoke<IHello, 0>(); }
+	virtual uint64_t Sum(Dom::Remote::Buffer data, uint64_t seed) { return Invoke<IChecksum, 0, uint64_t>(data, seed); }
+};
+class HelloProxy : public Dom::Remote::Proxy<HelloProxy, IHello> {
+public:
+	using Proxy::Proxy;
+	virtual void Say() { Invoke<IHello, 0>(); }
+};
+DOM_REMOTE_PROXY(ChecksumProxy)
+DOM_REMOTE_PROXY(HelloProxy)
+
+int main(int argc, char* argv[])
 {
+	if (int rc = Dom::Remote::Serve(argc, argv); rc >= 0) return rc;
+	if (access(Sample.c_str(), R_OK) != 0) {
+		fprintf(stderr, "Sample server `%s` not found, build skeleton/skel.cpp with DOM_SAMPLE or define DOM_SAMPLE_SO\n", Sample.c_str());
+		return 1;
+	}
+
 	/* Case #1 */
 	{
 		{
 			Dom::Client::Manager<> regitry;
-			regitry.RegisterServer("/home/irokez/projects/Dynamic-Object-Model/bin/x64/Debug-Skel/lib-sample.so");
+			regitry.RegisterServer(Sample);
 		}
 		
 		{
@@ -55,7 +140,7 @@ int main()
 		CManager manager;
 
 		/* Emplace Dom Server with class SimpleHello implementation */
-		manager.EmplaceServer("/home/irokez/projects/Dynamic-Object-Model/bin/x64/Debug-Skel/lib-sample.so", "");
+		manager.EmplaceServer(Sample, "");
 
 		/* Create new instance  of SimpleHello class */
 		Interface<IHello> hello;
@@ -64,10 +149,745 @@ int main()
 		/* Say Hello */
 		hello->Say();
 	}
-	
 
-	
-	return 0;
+	/* Case #3 */
+	{
+		/* CreateInstance throughput by thread count: lookups run against a published snapshot and should scale with cores,
+		   less than half of linear scaling while threads fit in half the hardware threads is taken as a serialized read path */
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(Sample, "");
+
+		const size_t Cores = std::max(1u, std::thread::hardware_concurrency());
+		double single = 0;
+		for (size_t threads = 1; threads <= Cores; threads *= 2) {
+			std::atomic_bool stop(false);
+			std::atomic_size_t total(0);
+			std::vector<std::thread> workers;
+			for (size_t n = 0; n < threads; n++) {
+				workers.emplace_back([&]() {
+					size_t count = 0;
+					while (!stop) {
+						Interface<IHello> hello;
+						manager.CreateInstance("QuietHello", hello, "");
+						count++;
+					}
+					total += count;
+				});
+			}
+			auto start = std::chrono::steady_clock::now();
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			stop = true;
+			for (auto&& worker : workers) worker.join();
+
+			double rate = total / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			single = threads == 1 ? rate : single;
+			printf("CreateInstance threads: %2zu, %12.0f ops/s, scaling %5.2fx\n", threads, rate, rate / single);
+			CHECK(total > 0);
+			CHECK(threads * 2 > Cores || rate / single >= threads * 0.5);
+		}
+	}
+
+	/* Case #4 */
+	{
+		/* Startup cost of LoadRegistry: eager opens every registered server, lazy only records the classes */
+		const std::string Registry("/tmp/dom-startup-registry/");
+		const size_t Servers = 100;
+
+		Dom::Client::Manager<> registry;
+		for (size_t n = 0; n < Servers; n++) {
+			auto so = "/tmp/dom-startup-" + std::to_string(n) + ".so";
+			std::ofstream(so, std::ios::binary) << std::ifstream(Sample, std::ios::binary).rdbuf();
+			registry.RegisterServer(so, Registry, "plugin-" + std::to_string(n));
+		}
+
+		for (auto mode : { Dom::Client::LoadMode::Lazy, Dom::Client::LoadMode::Eager }) {
+			auto start = std::chrono::steady_clock::now();
+			Dom::Client::Manager<> manager;
+			manager.LoadRegistry(Registry, mode);
+			auto loaded = std::chrono::steady_clock::now();
+
+			Interface<IHello> hello;
+			manager.CreateInstance("QuietHello", hello, "plugin-0");
+			auto created = std::chrono::steady_clock::now();
+
+			/* Lazy has opened the one server it created from, eager all of them */
+			IStatistics::Snapshot snapshot;
+			manager.EnableStatistics();
+			manager.GetStatistics(snapshot);
+			auto opened = std::count_if(snapshot.Servers.begin(), snapshot.Servers.end(), [](const IStatistics::Server& so) { return so.Loaded; });
+			CHECK(hello);
+			CHECK(Linked || (size_t)opened == (mode == Dom::Client::LoadMode::Lazy ? 1 : Servers));
+
+			/* The first use of each indexed class binds it in place: no table copy, no list lock */
+			size_t bound = 0;
+			for (size_t n = 0; n < Servers; n++) {
+				Interface<IHello> plugin;
+				bound += manager.CreateInstance("QuietHello", plugin, "plugin-" + std::to_string(n)) ? 1 : 0;
+			}
+			IStatistics::Snapshot warmed;
+			manager.GetStatistics(warmed);
+			CHECK(Linked || bound == Servers);
+			CHECK(Linked || mode != Dom::Client::LoadMode::Lazy || warmed.ListLock.Acquired == snapshot.ListLock.Acquired);
+
+			if (mode == Dom::Client::LoadMode::Lazy) {
+				/* A server whose classes are all unregistered is no longer pinned by the index that bound them */
+				auto so = "/tmp/dom-startup-0.so";
+				manager.UnRegisterServer(so, Registry, "plugin-0");
+				IStatistics::Snapshot unregistered;
+				manager.GetStatistics(unregistered);
+				auto pinned = std::count_if(unregistered.Servers.begin(), unregistered.Servers.end(), [](const IStatistics::Server& s) { return s.SoName.find("dom-startup-0.so") != std::string::npos; });
+				CHECK(Linked || (pinned == 0 && unregistered.Servers.size() == Servers - 1));
+				manager.RegisterServer(so, Registry, "plugin-0");
+			}
+
+			printf("LoadRegistry %-5s servers: %zu, load %8.3f ms, first CreateInstance %8.3f ms\n", mode == Dom::Client::LoadMode::Lazy ? "lazy" : "eager", Servers,
+				std::chrono::duration<double, std::milli>(loaded - start).count(), std::chrono::duration<double, std::milli>(created - loaded).count());
+		}
+
+		for (size_t n = 0; n < Servers; n++) {
+			auto so = "/tmp/dom-startup-" + std::to_string(n) + ".so";
+			registry.UnRegisterServer(so, Registry, "plugin-" + std::to_string(n));
+			remove(so.c_str());
+		}
+	}
+
+	/* Case #5 */
+	{
+		/* Fan-out: one CreateInstances call against the same number of single CreateInstance calls */
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(Sample, "");
+
+		const size_t Batch = 256, Rounds = 1000;
+		std::vector<Dom::IUnknown*> objects(Batch);
+		for (bool batched : { false, true }) {
+			/* QuietHello is pooled: after the first round every object is built in a block an earlier one released */
+			std::unordered_set<Dom::IUnknown*> blocks;
+			size_t reused = 0, total = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t r = 0; r < Rounds; r++) {
+				size_t created = batched ? manager.CreateInstances("QuietHello", Batch, (void**)objects.data(), "") : 0;
+				for (; !batched && created < Batch && manager.CreateInstance("QuietHello", (void**)&objects[created], ""); created++) { ; }
+				total += created;
+				for (size_t n = 0; n < created; n++) {
+					if (r == 0) blocks.insert(objects[n]); else reused += blocks.count(objects[n]);
+					objects[n]->Release();
+				}
+			}
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			printf("CreateInstance%s batch: %zu, %8.1f ns/object, pooled blocks reused %zu\n", batched ? "s " : "  ", Batch, elapsed / (Batch * Rounds), reused);
+			CHECK(total == Batch * Rounds);
+			CHECK(reused == Batch * (Rounds - 1));
+		}
+	}
+
+	/* Case #6 */
+	{
+		/* Every reference counting policy counts alike: AddRef/Release return the new count, the object goes at zero.
+		   The per-call cost of each is in benchmark/benchmark.cpp */
+		auto counts = [&](const char* name, Dom::IUnknown* unkn) {
+			auto destroyed = Destroyed;
+			bool counted = unkn->AddRef() == 1 && unkn->AddRef() == 2 && unkn->Release() == 1 && Destroyed == destroyed;
+			counted = unkn->Release() == 0 && Destroyed == destroyed + 1 && counted;
+			printf("RefCount %-7s %s\n", name, counted ? "checked" : "failed");
+			return counted;
+		};
+		CHECK(counts("strict", *new StrictHello));
+		CHECK(counts("relaxed", *new RelaxedHello));
+		CHECK(counts("single", *new SingleHello));
+	}
+
+	/* Case #7 */
+	{
+		/* create -> pass -> store: one AddRef at creation, one Release at the end, nothing in between */
+		{
+			std::vector<Interface<IHello>> store;
+			for (size_t n = 0; n < 64; n++) {
+				auto hello = MakeCounted();
+				SayBorrowed(hello);
+				store.push_back(std::move(hello));
+			}
+			Interface<IHello> last(std::move(store.back()));
+			store.pop_back();
+			SayBorrowed(last);
+			store.front() = std::move(last);
+		}
+		printf("Interface hand-off: %ld AddRef, %ld Release for 64 objects\n", CountedHello::AddRefs, CountedHello::Releases);
+		/* Anything more is redundant reference traffic */
+		CHECK(CountedHello::AddRefs == 64);
+		CHECK(CountedHello::Releases == 64);
+	}
+
+	/* Case #8 */
+	{
+		/* Statistics snapshot, as a metrics scraper would read it */
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(Sample, "");
+		manager.EnableStatistics();
+
+		for (size_t n = 0; n < 1000; n++) {
+			Interface<IHello> hello;
+			manager.CreateInstance("QuietHello", hello, "");
+		}
+		Interface<IHello> kept, missing;
+		manager.CreateInstance("QuietHello", kept, "");
+		manager.CreateInstance("NoSuchClass", missing, "");
+
+		Interface<IStatistics> statistics((Dom::IUnknown*)manager);
+		IStatistics::Snapshot snapshot;
+		if (statistics && statistics->GetStatistics(snapshot)) {
+			for (auto&& cls : snapshot.Classes) printf("class %s [%s] creates %lu failures %lu live %ld\n", cls.Name.c_str(), cls.Scope.c_str(), cls.Creates, cls.Failures, cls.Live);
+			for (auto&& scope : snapshot.Scopes) printf("scope [%s] creates %lu failures %lu\n", scope.Name.c_str(), scope.Creates, scope.Failures);
+			for (auto&& server : snapshot.Servers) printf("server %s loaded %d in %lu ns\n", server.SoName.c_str(), server.Loaded, server.LoadNanos);
+			printf("not found %lu, create latency %lu calls %.1f ns avg, list lock %lu acquired %lu ns held\n", snapshot.NotFound, snapshot.CreateLatency.Total,
+				snapshot.CreateLatency.Total ? (double)snapshot.CreateLatency.SumNanos / snapshot.CreateLatency.Total : 0.0, snapshot.ListLock.Acquired, snapshot.ListLock.HoldNanos);
+		}
+		CHECK(statistics);
+		auto quiet = std::find_if(snapshot.Classes.begin(), snapshot.Classes.end(), [](const IStatistics::Class& cls) { return cls.Name == "QuietHello"; });
+		CHECK(Linked || (quiet != snapshot.Classes.end() && quiet->Creates == 1001 && quiet->Failures == 0 && quiet->Live == 1));
+		CHECK(snapshot.NotFound == 1);
+		CHECK(snapshot.CreateLatency.Total == 1001);
+	}
+
+	/* Case #9 */
+	{
+#ifdef DOM_TRACE
+		/* Binary trace of a load and a few creates, read back in the dump layout tools/tracedecode.cpp decodes */
+		char Dump[] = "/tmp/dom-testcases-trace.XXXXXX";
+		int fd = mkstemp(Dump);
+		CHECK(fd >= 0);
+		if (fd >= 0) close(fd);
+		auto tracer = Dom::Trace::Tracer::Current();
+		tracer->Enable(true, 1024);
+		const size_t Creates = 10;
+		{
+			Dom::Client::Manager<> manager;
+			manager.EmplaceServer(Sample, "");
+			for (size_t n = 0; n < Creates; n++) {
+				Interface<IHello> hello;
+				manager.CreateInstance("QuietHello", hello, "");
+			}
+		}
+		tracer->Enable(false);
+		CHECK(tracer->Dump(Dump));
+
+		std::ifstream in(Dump, std::ios::binary);
+		auto Read = [&](void* data, size_t length) { return (bool)in.read((char*)data, length); };
+		auto Text = [&](std::string& text) { uint32_t length = 0; if (!Read(&length, sizeof(length))) return false; text.resize(length); return length == 0 || Read(&text[0], length); };
+		char magic[8];
+		uint32_t header[4] = { 0, 0, 0, 0 };
+		CHECK(Read(magic, sizeof(magic)) && memcmp(magic, "DOMTRACE", 8) == 0 && Read(header, sizeof(header)));
+		CHECK(header[0] == Dom::Trace::Tracer::Version && header[3] == sizeof(Dom::Trace::Record) && header[2] >= 1);
+		/* Sites of the create path: the lookup in CreateInstance records `scope/class` */
+		std::vector<bool> creating(header[1]);
+		for (uint32_t n = 0; n < header[1]; n++) {
+			uint32_t info[2];
+			std::string function, format, file;
+			if (!Read(info, sizeof(info)) || !Text(function) || !Text(format) || !Text(file)) break;
+			creating[n] = format == "%s/%s" && function.find("CreateInstance(") != std::string::npos;
+		}
+		size_t records = 0, created = 0;
+		for (uint32_t n = 0; n < header[2]; n++) {
+			uint32_t info[2] = { 0, 0 };
+			if (!Read(info, sizeof(info))) break;
+			std::vector<Dom::Trace::Record> ring(info[1]);
+			if (!ring.empty() && !Read(ring.data(), ring.size() * sizeof(Dom::Trace::Record))) break;
+			records += ring.size();
+			for (auto&& r : ring) created += r.site < creating.size() && creating[r.site] ? 1 : 0;
+		}
+		CHECK(in && created == Creates);
+		printf("Trace dump: %u rings, %zu records, %zu creates\n", header[2], records, created);
+		remove(Dump);
+#else
+		printf("Trace dump: build with DOM_TRACE\n");
+#endif // DOM_TRACE
+	}
+
+	/* Case #10 */
+	{
+		/* Deploy step: one RegisterServer per plugin against a single RegisterServers call, then EmplaceServers of the same set */
+		const std::string Registry("/tmp/dom-bulk-registry/");
+		const size_t Servers = 100;
+
+		std::vector<std::string> plugins;
+		for (size_t n = 0; n < Servers; n++) {
+			plugins.push_back("/tmp/dom-bulk-" + std::to_string(n) + ".so");
+			std::ofstream(plugins.back(), std::ios::binary) << std::ifstream(Sample, std::ios::binary).rdbuf();
+		}
+		plugins.push_back("/tmp/dom-bulk-missing.so");
+
+		Dom::Client::Manager<> registry;
+		for (bool bulk : { false, true }) {
+			auto start = std::chrono::steady_clock::now();
+			size_t failed = 0;
+			if (bulk) {
+				std::vector<std::pair<std::string, std::string>> scoped;
+				for (auto&& so : plugins) scoped.emplace_back(so, "bulk-" + so.substr(5));
+				for (auto&& report : registry.RegisterServers(scoped, Registry)) { failed += !report.Succeeded; }
+			}
+			else {
+				for (auto&& so : plugins) {
+					try { failed += !registry.RegisterServer(so, Registry, "single-" + so.substr(5)); }
+					catch (std::exception& ex) { failed++; }
+				}
+			}
+			printf("Register%-8s servers: %zu, %8.3f ms, failed %zu\n", bulk ? "Servers" : "Server", plugins.size(),
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), failed);
+			/* Only the missing server */
+			CHECK(failed == 1);
+		}
+
+		Dom::Client::Manager<> manager;
+		auto reports = manager.EmplaceServers(plugins, "emplaced");
+		size_t failed = 0;
+		for (auto&& report : reports) {
+			if (!report.Succeeded) printf("EmplaceServers `%s` failed: %s\n", report.SoServer.c_str(), report.Error.c_str());
+			failed += !report.Succeeded;
+		}
+		Interface<IHello> hello;
+		bool bound = manager.CreateInstance("QuietHello", hello, "emplaced");
+		printf("EmplaceServers classes bound: %s\n", bound ? "yes" : "no");
+		CHECK(reports.size() == plugins.size() && failed == 1 && !reports.back().Succeeded);
+		CHECK(bound);
+
+		/* Both registrations are in the index */
+		Dom::Client::Manager<> loaded;
+		loaded.LoadRegistry(Registry, Dom::Client::LoadMode::Lazy);
+		Interface<IHello> single, bulk;
+		CHECK(loaded.CreateInstance("QuietHello", single, "single-" + plugins.front().substr(5)));
+		CHECK(loaded.CreateInstance("QuietHello", bulk, "bulk-" + plugins.front().substr(5)));
+
+		plugins.pop_back();
+		for (auto&& so : plugins) {
+			registry.UnRegisterServer(so, Registry, "single-" + so.substr(5));
+			remove(so.c_str());
+		}
+		system(("rm -rf '" + Registry + "' /tmp/dom-bulk-registry.index").c_str());
+	}
+
+	/* Case #11 */
+	{
+		/* Event-loop thread: the first create of a lazily bound class is handed to the pool, later ones complete inline */
+		const std::string Registry("/tmp/dom-async-registry/");
+		Dom::Client::Manager<> registry;
+		registry.RegisterServer(Sample, Registry, "async");
+
+		Dom::Client::Manager<> manager;
+		manager.EnableStatistics();
+		manager.LoadRegistry(Registry, Dom::Client::LoadMode::Lazy);
+		for (size_t n = 0; n < 2; n++) {
+			auto start = std::chrono::steady_clock::now();
+			auto pending = manager.CreateInstanceAsync("QuietHello", "async");
+			auto returned = std::chrono::steady_clock::now();
+			bool ready = pending.Ready();
+			Interface<IHello> hello;
+			hello.Attach(pending.Get());
+			printf("CreateInstanceAsync #%zu: returned in %8.3f ms, %s, created %s\n", n + 1, std::chrono::duration<double, std::milli>(returned - start).count(),
+				ready ? "completed inline" : "pending on the pool", hello ? "yes" : "no");
+			CHECK(hello);
+			/* The class is bound by now */
+			CHECK(n == 0 || ready);
+		}
+
+		std::promise<bool> called;
+		manager.CreateInstanceAsync("QuietHello", [&](Dom::IUnknown* unkn, std::exception_ptr error) {
+			if (unkn != nullptr) unkn->Release();
+			called.set_value(unkn != nullptr && !error);
+		}, "async");
+		bool created = called.get_future().get();
+		printf("CreateInstanceAsync callback: %s\n", created ? "created" : "failed");
+		CHECK(created);
+
+		/* A result dropped without Get() releases its object */
+		manager.CreateInstanceAsync("QuietHello", "async").Wait();
+		IStatistics::Snapshot snapshot;
+		manager.GetStatistics(snapshot);
+		auto quiet = std::find_if(snapshot.Classes.begin(), snapshot.Classes.end(), [](const IStatistics::Class& cls) { return cls.Name == "QuietHello"; });
+		CHECK(quiet != snapshot.Classes.end() && quiet->Creates == 4 && quiet->Live == 0);
+
+		registry.UnRegisterServer(Sample, Registry, "async");
+	}
+
+	/* Case #12 */
+	{
+		/* Multi-tenant: one class in many scopes, direct lookups against memoized fallbacks from nested scopes */
+		const size_t Tenants = 200, Calls = 100000;
+		Dom::Client::Manager<> manager;
+		for (size_t n = 0; n < Tenants; n++) {
+			manager.EmplaceServer(Sample, "tenant-" + std::to_string(n));
+		}
+		manager.EnableScopeFallback();
+
+		for (auto scope : { "tenant-199", "tenant-7/a/b" }) {
+			Dom::IUnknown* unkn;
+			size_t created = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t n = 0; n < Calls; n++) {
+				if (manager.CreateInstance("QuietHello", (void**)&unkn, scope)) { unkn->Release(); created++; }
+			}
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			printf("CreateInstance scope `%s` of %zu: %8.1f ns/call, created %zu\n", scope, Tenants, elapsed / Calls, created);
+			CHECK(created == Calls);
+		}
+
+		/* Per-request scopes nothing is bound in fall back to the tenant without being interned */
+		size_t interned = ScopePool::Instance().Interned(), created = 0;
+		for (size_t n = 0; n < 1000; n++) {
+			Interface<IHello> hello;
+			created += manager.CreateInstance("QuietHello", hello, "tenant-7/request-" + std::to_string(n));
+		}
+		CHECK(created == 1000);
+		CHECK(ScopePool::Instance().Interned() == interned);
+	}
+
+	/* Case #13 */
+	{
+		/* Idle sweeper: a server with a live object is kept, once released it is finalized and closed on the second pass that
+		   finds it drained, the next create reopens it */
+		const std::chrono::nanoseconds Idle(0);
+		Dom::Client::Manager<> manager;
+		manager.EnableStatistics();
+		manager.EmplaceServer(Sample, "sweep");
+		{
+			Interface<IHello> hello;
+			manager.CreateInstance("QuietHello", hello, "sweep");
+			size_t closed = manager.SweepIdleServers(Idle) + manager.SweepIdleServers(Idle);
+			printf("SweepIdleServers with a live object: %zu closed\n", closed);
+			CHECK(Linked || closed == 0);
+		}
+		size_t first = manager.SweepIdleServers(Idle), second = manager.SweepIdleServers(Idle);
+		printf("SweepIdleServers once released: %zu closed on the first pass, %zu on the second\n", first, second);
+		CHECK(Linked || (first == 0 && second == 1));
+		Interface<IHello> hello;
+		bool reloaded = manager.CreateInstance("QuietHello", hello, "sweep");
+		printf("CreateInstance after sweep: %s\n", reloaded ? "reloaded" : "failed");
+		CHECK(reloaded);
+		/* A call since the last pass starts over */
+		CHECK(manager.SweepIdleServers(Idle) == 0);
+
+		IStatistics::Snapshot snapshot;
+		manager.GetStatistics(snapshot);
+		for (auto&& so : snapshot.Servers) {
+			printf("Server `%s`: loads %lu, unloads %lu, reclaimed %lu bytes\n", so.SoName.c_str(), so.Loads, so.Unloads, so.ReclaimedBytes);
+		}
+		CHECK(Linked || (snapshot.Servers.size() == 1 && snapshot.Servers[0].Loads == 2 && snapshot.Servers[0].Unloads == 1));
+	}
+
+	/* Case #14 */
+	{
+		/* Build with DOM_STATIC_SERVER and link skeleton/skel.cpp in: QuietHello is created without a registry or dlopen */
+		const size_t Calls = 1000000;
+		Dom::Client::Manager<> manager;
+		Interface<IHello> hello;
+		bool linked = manager.CreateInstance("QuietHello", hello);
+		printf("Linked classes: %zu, QuietHello %s\n", LinkedServers::Instance().Classes().size(), linked ? "linked" : "not linked");
+		/* No registry was loaded: only a linked class can be created, from a server that is resident and never dlopen'ed */
+		CHECK(linked == Linked);
+		IStatistics::Snapshot snapshot;
+		manager.EnableStatistics();
+		manager.GetStatistics(snapshot);
+		CHECK(!Linked || (!snapshot.Servers.empty() && std::all_of(snapshot.Servers.begin(), snapshot.Servers.end(), [](const IStatistics::Server& so) { return so.Loaded && so.Loads == 0; })));
+		if (linked) {
+			IUnknown* unkn;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t n = 0; n < Calls; n++) {
+				if (manager.CreateInstance("QuietHello", (void**)&unkn)) unkn->Release();
+			}
+			printf("CreateInstance linked: %8.1f ns/call\n", std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / Calls);
+		}
+	}
+
+	/* Case #15 */
+	{
+		/* Host allocator: objects created inside a request come from its arena and are given back with one Reset() */
+		const size_t Objects = 1000;
+		Dom::Client::Manager<> manager;
+		manager.EnableAllocator();
+		manager.EmplaceServer(Sample, "arena");
+
+		Dom::Client::RequestArena arena;
+		IUnknown* first = nullptr;
+		size_t chunks = 0;
+		for (size_t request = 0; request < 3; request++) {
+			std::vector<IUnknown*> objects(Objects, nullptr);
+			{
+				Dom::Client::RequestArena::Scope scope(arena);
+				manager.CreateInstances("QuietHello", Objects, (void**)objects.data(), "arena");
+			}
+			long live = arena.Live();
+			bool refused = !arena.Reset();
+			for (auto&& unkn : objects) { if (unkn != nullptr) unkn->Release(); }
+			bool reset = arena.Reset();
+			printf("Request #%zu: %ld objects from the arena (%zu chunks), reset %s\n", request + 1, live, arena.Chunks(), reset ? "done" : "refused");
+			/* Nothing is reset under live objects, a reset arena hands its chunks out again from the start */
+			CHECK(Linked || (live == (long)Objects && refused && reset && arena.Live() == 0));
+			CHECK(Linked || request == 0 || (objects.front() == first && arena.Chunks() == chunks));
+			first = objects.front();
+			chunks = arena.Chunks();
+		}
+	}
+
+	/* Case #16 */
+	{
+		/* Out-of-process server: the sample runs in a child host, its objects are proxies behind the usual API */
+		const size_t Objects = 100;
+		Dom::Client::Manager<> manager;
+		manager.EmplaceRemoteServer(Sample, "remote");
+
+		Interface<IHello> hello;
+		manager.CreateInstance("SimpleHello", hello, "remote");
+		hello->Say();
+
+		/* A copied buffer and one already in shared memory give the same sum */
+		Interface<IChecksum> checksum;
+		manager.CreateInstance("Checksum", checksum, "remote");
+		const char text[] = "The quick brown fox jumps over the lazy dog";
+		auto copied = checksum->Sum({ (void*)text, sizeof(text) - 1 }, 1);
+		auto shared = Dom::Remote::Allocate(checksum, sizeof(text) - 1);
+		memcpy(shared.Data, text, shared.Size);
+		auto inplace = checksum->Sum(shared, 1);
+		Dom::Remote::Free(checksum, shared);
+		printf("Remote checksum %s (%lx)\n", copied == inplace && copied == Dom::GuidFold(text, sizeof(text) - 1, 1) ? "matches" : "differs", (unsigned long)copied);
+		CHECK(copied == inplace && copied == Dom::GuidFold(text, sizeof(text) - 1, 1));
+
+		std::vector<IUnknown*> objects(Objects, nullptr);
+		auto created = manager.CreateInstances("QuietHello", Objects, (void**)objects.data(), "remote");
+		for (auto&& unkn : objects) { if (unkn != nullptr) { Interface<IHello>(unkn)->Say(); unkn->Release(); } }
+		printf("Remote batch: %zu of %zu objects\n", created, Objects);
+		CHECK(created == Objects);
+
+		/* A crashed host fails calls, not the client; with DOM_STATIC_SERVER the linked sample wins and nothing is remote */
+		Interface<Dom::Remote::IProxy> proxy(hello);
+		if (proxy) {
+			kill(proxy->Host().Pid(), SIGKILL);
+			bool failed = false;
+			try { hello->Say(); printf("Call on a killed host returned\n"); }
+			catch (std::system_error& ex) { printf("Call on a killed host: %s\n", ex.what()); failed = true; }
+			IUnknown* unkn;
+			bool created = manager.CreateInstance("SimpleHello", (void**)&unkn, "remote");
+			printf("Create on a killed host: %s\n", created ? "created" : "failed");
+			CHECK(failed && !created);
+		}
+	}
+
+	/* Case #17 */
+	{
+		/* Activation models: a singleton and per-thread objects come back with one AddRef, a pool never grows past its size,
+		   objects only the caches hold let the sweeper finalize and close the server */
+		const size_t Calls = 1000000, Threads = 16;
+		const std::chrono::nanoseconds Idle(0);
+		Dom::Client::Manager<> manager;
+		manager.EmplaceServer(Sample, "activation");
+
+		for (auto cls : { "QuietHello", "SharedHello" }) {
+			IUnknown* first = nullptr, *unkn;
+			manager.CreateInstance(cls, (void**)&first, "activation");
+			size_t same = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t n = 0; n < Calls; n++) {
+				if (manager.CreateInstance(cls, (void**)&unkn, "activation")) { same += unkn == first; unkn->Release(); }
+			}
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			printf("CreateInstance %-12s %8.1f ns/call, same object %zu of %zu\n", cls, elapsed / Calls, same, Calls);
+			/* Per call while the first is held, one singleton */
+			CHECK(first != nullptr && same == (std::string(cls) == "SharedHello" ? Calls : 0));
+			if (first != nullptr) first->Release();
+		}
+
+		for (auto cls : { "ThreadHello", "PooledHello" }) {
+			/* References are kept past the join, so an exited thread's object is not reused for the next one */
+			std::mutex lock;
+			std::vector<IUnknown*> held;
+			std::vector<std::thread> threads;
+			bool stable = true;
+			for (size_t n = 0; n < Threads; n++) {
+				threads.emplace_back([&]() {
+					IUnknown* first = nullptr, *again = nullptr;
+					manager.CreateInstance(cls, (void**)&first, "activation");
+					manager.CreateInstance(cls, (void**)&again, "activation");
+					std::unique_lock<std::mutex> sync(lock);
+					stable = stable && first != nullptr && first == again;
+					if (again != nullptr) again->Release();
+					if (first != nullptr) held.push_back(first);
+				});
+			}
+			for (auto&& thread : threads) thread.join();
+			auto objects = held;
+			std::sort(objects.begin(), objects.end());
+			objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+			for (auto unkn : held) unkn->Release();
+			printf("%s over %zu threads: %zu objects, same object within a thread: %s\n", cls, Threads, objects.size(), stable ? "yes" : "no");
+			/* One object per thread; the pool holds four */
+			CHECK(stable && held.size() == Threads);
+			CHECK(objects.size() == (std::string(cls) == "ThreadHello" ? Threads : 4));
+		}
+
+		{
+			Interface<IHello> hello;
+			manager.CreateInstance("SharedHello", hello, "activation");
+			size_t closed = manager.SweepIdleServers(Idle) + manager.SweepIdleServers(Idle);
+			printf("SweepIdleServers with a singleton in use: %zu closed\n", closed);
+			CHECK(Linked || closed == 0);
+		}
+		manager.SweepIdleServers(Idle);
+		size_t closed = manager.SweepIdleServers(Idle);
+		printf("SweepIdleServers with cached objects only: %zu closed\n", closed);
+		Interface<IHello> hello;
+		bool reloaded = manager.CreateInstance("SharedHello", hello, "activation");
+		printf("CreateInstance after sweep: %s\n", reloaded ? "reloaded" : "failed");
+		CHECK(Linked || (closed == 1 && reloaded));
+	}
+
+	/* Case #18 */
+	{
+		/* Server descriptor stored at registration: interfaces and activation of every class come from the registry index */
+		const std::string Registry("/tmp/dom-describe-registry/");
+		Dom::Client::Manager<> registry;
+		registry.RegisterServer(Sample, Registry, "described");
+
+		Dom::Client::Manager<> manager;
+		for (auto iid : { IHello::guid(), IChecksum::guid(), Dom::IId("Missing") }) {
+			size_t found = 0;
+			for (auto&& cls : manager.EnumImplementers(iid, Registry)) { found++; (void)cls; }
+			printf("Classes implementing `%s`: %zu\n", iid.c_str(), found);
+			/* Every sample class says hello, one sums */
+			CHECK(found == (iid == IHello::guid() ? 6 : iid == IChecksum::guid() ? 1 : 0));
+		}
+		Dom::Client::ClassDescription description;
+		bool described = manager.DescribeClass("PooledHello", description, Registry, "described");
+		CHECK(described && description.Interfaces.size() == 2 && (description.Flags & ServerDescriptor::ModelMask) == ServerDescriptor::Pooled && description.Slots == 4);
+		if (described) {
+			std::string iids;
+			for (auto&& iid : description.Interfaces) iids += (iids.empty() ? "" : ", ") + iid;
+			printf("Class `%s`: %s; model %u, %u slots, pooled memory %s, %lu bytes\n", description.ClsId.c_str(), iids.c_str(), description.Flags & ServerDescriptor::ModelMask,
+				description.Slots, description.Flags & ServerDescriptor::PooledMemory ? "yes" : "no", (unsigned long)description.Size);
+		}
+		else printf("Class `PooledHello` not described\n");
+
+		/* The stored descriptor goes with the last scope the server is registered in */
+		auto Descriptions = [&]() {
+			size_t files = 0;
+			if (auto dir = opendir((Registry + ".servers").c_str())) {
+				while (auto f = readdir(dir)) files += f->d_name[0] != '.' ? 1 : 0;
+				closedir(dir);
+			}
+			return files;
+		};
+		auto stored = Descriptions();
+		registry.RegisterServer(Sample, Registry, "again");
+		registry.UnRegisterServer(Sample, Registry, "again");
+		CHECK(stored > 0 && Descriptions() == stored);
+		registry.UnRegisterServer(Sample, Registry, "described");
+		CHECK(Descriptions() == stored - 1);
+		auto left = manager.EnumImplementers(IHello::guid(), Registry);
+		printf("Classes implementing `%s` once unregistered: %zu\n", IHello::guid().c_str(), (size_t)std::distance(left.begin(), left.end()));
+		CHECK(left.begin() == left.end());
+	}
+
+	/* Case #19 */
+	{
+		/* Two managers, one with an allocator and statistics: with DOM_QI_CACHE neither answer leaks to the other through the cache */
+		Dom::Client::Manager<> a, b;
+		a.EnableAllocator();
+		a.EnableStatistics();
+		for (size_t n = 0; n < 2; n++) {
+			Interface<IAllocator> aAllocator((Dom::IUnknown*)a), bAllocator((Dom::IUnknown*)b);
+			Interface<IStatistics> aStatistics((Dom::IUnknown*)a), bStatistics((Dom::IUnknown*)b);
+			CHECK(aAllocator && (IAllocator*)aAllocator == &Dom::Client::ArenaAllocator::Instance() && !bAllocator);
+			CHECK(aStatistics && !bStatistics);
+		}
+		a.EnableStatistics(false);
+		Interface<IStatistics> disabled((Dom::IUnknown*)a);
+		CHECK(!disabled);
+		printf("Manager interfaces with a per-manager state: checked\n");
+	}
+
+	/* Case #20 */
+	{
+		/* Registry index: built when missing, stale once a link is added behind the manager's back, a tree walk when it cannot be written */
+		using Dom::Client::RegistryIndex;
+		const std::string Registry("/tmp/dom-index-registry/");
+		auto IndexName = RegistryIndex::FileName(Registry);
+		auto Created = [&](const std::string& Scope) {
+			Dom::Client::Manager<> manager;
+			manager.LoadRegistry(Registry, Dom::Client::LoadMode::Lazy);
+			Interface<IHello> hello;
+			return manager.CreateInstance("QuietHello", hello, Scope) && hello;
+		};
+		Dom::Client::Manager<> registry;
+		registry.RegisterServer(Sample, Registry, "indexed");
+		remove(IndexName.c_str());
+		CHECK(!RegistryIndex(Registry).Valid());
+		CHECK(Created("indexed") && RegistryIndex(Registry).Valid());
+
+		/* A directory stamped no earlier than the index was written may still change within the same tick: not fresh until rebuilt */
+		auto Touch = [&](time_t when) {
+			const struct timespec times[2] = { { 0, UTIME_OMIT }, { when, 0 } };
+			for (auto dir : { Registry, Registry + "indexed" }) utimensat(AT_FDCWD, dir.c_str(), times, 0);
+		};
+		Touch(time(nullptr) + 3600);
+		RegistryIndex::Build(Registry);
+		CHECK(!RegistryIndex(Registry).Fresh(Registry));
+		Touch(time(nullptr) - 3600);
+		RegistryIndex::Build(Registry);
+		CHECK(RegistryIndex(Registry).Fresh(Registry));
+		mkdir((Registry + "behind").c_str(), 0755);
+		const std::string Behind(Registry + "behind/" + Dom::ClsId("QuietHello").c_str());
+		symlink(Sample.c_str(), Behind.c_str());
+		CHECK(!RegistryIndex(Registry).Fresh(Registry));
+		CHECK(Created("behind"));
+		RegistryIndex rebuilt(Registry);
+		CHECK(rebuilt.Valid() && rebuilt.Find(Dom::ClsId("QuietHello"), "behind") != nullptr);
+
+		/* An index that cannot be replaced: LoadRegistry walks the tree, the next one rebuilds */
+		remove(IndexName.c_str());
+		mkdir(IndexName.c_str(), 0755);
+		CHECK(Created("behind") && Created("indexed"));
+		rmdir(IndexName.c_str());
+		CHECK(Created("behind") && RegistryIndex(Registry).Valid());
+		printf("Registry index: missing, stale and unwritable: checked\n");
+
+		remove(Behind.c_str());
+		rmdir((Registry + "behind").c_str());
+		registry.UnRegisterServer(Sample, Registry, "indexed");
+	}
+
+	/* Case #21 */
+	{
+		/* Registry watcher: a link added, a link removed and a scope directory moved out of the tree reach the class table */
+		const std::string Registry("/tmp/dom-watch-registry/"), Moved("/tmp/dom-watch-moved/");
+		const std::string Quiet(Dom::ClsId("QuietHello").c_str()), Simple(Dom::ClsId("SimpleHello").c_str());
+		Dom::Client::Manager<> registry;
+		registry.RegisterServer(Sample, Registry, "t/b");
+
+		Dom::Client::Manager<> manager;
+		auto Created = [&](const char* cid, const std::string& Scope) { Interface<IHello> hello; return manager.CreateInstance(cid, hello, Scope) && hello; };
+		CHECK(manager.WatchRegistry(Registry) >= 0);
+		CHECK(Created("QuietHello", "t/b"));
+		CHECK(Linked || !Created("QuietHello", "t/c"));
+
+		mkdir((Registry + "t/c").c_str(), 0755);
+		symlink(Sample.c_str(), (Registry + "t/c/" + Quiet).c_str());
+		CHECK(manager.ProcessRegistryEvents() && Created("QuietHello", "t/c"));
+
+		remove((Registry + "t/c/" + Quiet).c_str());
+		CHECK(manager.ProcessRegistryEvents() && (Linked || !Created("QuietHello", "t/c")));
+
+		/* Moved out, the scope is gone, and links made in it afterwards are not registry classes */
+		rename((Registry + "t/b").c_str(), Moved.c_str());
+		CHECK(manager.ProcessRegistryEvents() && (Linked || !Created("QuietHello", "t/b")));
+		symlink(Sample.c_str(), (Moved + Simple).c_str());
+		CHECK(!manager.ProcessRegistryEvents() && (Linked || !Created("SimpleHello", "t/b")));
+		printf("Registry watcher: added, removed and moved out: checked\n");
+
+		manager.UnwatchRegistry();
+		remove((Moved + Simple).c_str());
+		rename(Moved.c_str(), (Registry + "t/b").c_str());
+		rmdir((Registry + "t/c").c_str());
+		registry.UnRegisterServer(Sample, Registry, "t/b");
+	}
+
+	printf("%d checks failed\n", Failures);
+	return Failures;
 }
 
 /*
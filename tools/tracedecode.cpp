@@ -0,0 +1,147 @@
+#ifdef DOM_TRACE_DECODER
+
+/*
+	Offline decoder for Dom::Trace::Tracer::Dump files. Records of all threads are merged by timestamp and printed
+	in the old DOM_CALL_TRACE/DOM_ERR text form, function names are shortened here instead of at the call site.
+	Build with DOM_TRACE_DECODER defined, e.g. `c++ -std=c++17 -O2 -DDOM_TRACE_DECODER -I. tools/tracedecode.cpp -o dom-tracedecode`
+
+	dom-tracedecode <dump> [--errors]
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <regex>
+#include <fstream>
+#include <algorithm>
+#include "../src/dom/core/trace.h"
+
+namespace {
+
+	struct Site {
+		uint32_t	line, level;
+		std::string	function, format, file;
+	};
+
+	struct Event {
+		uint64_t				stamp;
+		uint32_t				thread;
+		Dom::Trace::Record*		record;
+	};
+
+	class Reader {
+		std::ifstream	in;
+	public:
+		Reader(const char* path) : in(path, std::ios::binary) { ; }
+		inline operator bool() const { return (bool)in; }
+		template<typename T> inline bool Read(T& value) { return (bool)in.read((char*)&value, sizeof(T)); }
+		inline bool Read(void* data, size_t length) { return (bool)in.read((char*)data, length); }
+		inline bool Read(std::string& text) {
+			uint32_t length;
+			if (!Read(length)) return false;
+			text.resize(length);
+			return length == 0 || Read(&text[0], length);
+		}
+	};
+
+	/* `ns::Class<T>::Method(args) const` -> `ns::Class::Method` */
+	static inline std::string Function(const std::string& pretty) {
+		static const std::regex re_fn(R"((.*?)(?:<.*?>)?(::~?\w+)\(.*)");
+		static const std::regex re_return(R"((?:[\w\s]+\s+)?(.*))");
+		return std::regex_replace(std::regex_replace(pretty, re_fn, "$1$2"), re_return, "$1");
+	}
+
+	/* printf with the recorded arguments; length modifiers are replaced by the recorded width of each argument */
+	static inline std::string Format(const std::string& format, const Dom::Trace::Record& r) {
+		using Kind = Dom::Trace::Record::Kind;
+		std::string out;
+		size_t at = 0, n = 0;
+		char buffer[512];
+		for (size_t p = 0; p < format.length(); p++) {
+			if (format[p] != '%') { out += format[p]; continue; }
+			if (p + 1 < format.length() && format[p + 1] == '%') { out += '%'; p++; continue; }
+
+			std::string spec("%");
+			size_t q = p + 1;
+			while (q < format.length() && strchr("-+ #0123456789.*", format[q])) spec += format[q++];
+			while (q < format.length() && strchr("hlLqjzt", format[q])) q++;
+			char conv = q < format.length() ? format[q] : 's';
+			p = q;
+
+			auto kind = n < Dom::Trace::Record::Args ? (Kind)((r.types >> (4 * n)) & 0xF) : Kind::End;
+			n++;
+			switch (kind) {
+			case Kind::Int: case Kind::UInt: {
+				uint64_t v; std::memcpy(&v, r.payload + at, sizeof(v)); at += sizeof(v);
+				if (conv == 'f' || conv == 'e' || conv == 'g' || conv == 's' || conv == 'p' || conv == 'c') conv = kind == Kind::Int ? 'd' : 'u';
+				if (kind == Kind::Int && (conv == 'd' || conv == 'i')) snprintf(buffer, sizeof(buffer), (spec + "ll" + conv).c_str(), (long long)v);
+				else snprintf(buffer, sizeof(buffer), (spec + "ll" + conv).c_str(), (unsigned long long)v);
+				break;
+			}
+			case Kind::Double: {
+				double v; std::memcpy(&v, r.payload + at, sizeof(v)); at += sizeof(v);
+				snprintf(buffer, sizeof(buffer), (spec + (strchr("fFeEgGaA", conv) ? conv : 'g')).c_str(), v);
+				break;
+			}
+			case Kind::Pointer: {
+				uint64_t v; std::memcpy(&v, r.payload + at, sizeof(v)); at += sizeof(v);
+				snprintf(buffer, sizeof(buffer), "%p", (void*)(uintptr_t)v);
+				break;
+			}
+			case Kind::String: {
+				std::string v((const char*)r.payload + at + 1, r.payload[at]); at += 1 + r.payload[at];
+				snprintf(buffer, sizeof(buffer), (spec + 's').c_str(), v.c_str());
+				break;
+			}
+			default:
+				snprintf(buffer, sizeof(buffer), "<?>");
+				break;
+			}
+			out += buffer;
+		}
+		return out;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) { fprintf(stderr, "usage: %s <dump> [--errors]\n", argv[0]); return 1; }
+	bool errors = argc > 2 && !strcmp(argv[2], "--errors");
+
+	Reader in(argv[1]);
+	char magic[8];
+	uint32_t header[4];
+	if (!in || !in.Read(magic, sizeof(magic)) || memcmp(magic, "DOMTRACE", 8) != 0 || !in.Read(header)) { fprintf(stderr, "`%s` is not a trace dump\n", argv[1]); return 1; }
+	if (header[0] != Dom::Trace::Tracer::Version || header[3] != sizeof(Dom::Trace::Record)) { fprintf(stderr, "Unsupported trace version %u (record %u bytes)\n", header[0], header[3]); return 1; }
+
+	std::vector<Site> sites(header[1]);
+	for (auto&& site : sites) {
+		uint32_t info[2];
+		if (!in.Read(info) || !in.Read(site.function) || !in.Read(site.format) || !in.Read(site.file)) { fprintf(stderr, "Truncated site table\n"); return 1; }
+		site.line = info[0]; site.level = info[1];
+		site.function = Function(site.function);
+	}
+
+	std::vector<std::vector<Dom::Trace::Record>> rings(header[2]);
+	std::vector<Event> events;
+	for (auto&& ring : rings) {
+		uint32_t info[2];
+		if (!in.Read(info)) { fprintf(stderr, "Truncated ring\n"); return 1; }
+		ring = std::vector<Dom::Trace::Record>(info[1]);
+		if (!ring.empty() && !in.Read(ring.data(), ring.size() * sizeof(Dom::Trace::Record))) { fprintf(stderr, "Truncated ring\n"); return 1; }
+		for (auto&& r : ring) events.push_back({ r.stamp, info[0], &r });
+	}
+	std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.stamp < b.stamp; });
+
+	uint64_t origin = events.empty() ? 0 : events.front().stamp;
+	for (auto&& e : events) {
+		if (e.record->site >= sites.size()) continue;
+		auto&& site = sites[e.record->site];
+		if (errors && site.level != Dom::Trace::Error) continue;
+		printf("%12.3f %6u [ %s::%s ] %s\n", (e.stamp - origin) / 1e3, e.thread, site.level == Dom::Trace::Error ? "ERROR" : "TRACE", site.function.c_str(), Format(site.format, *e.record).c_str());
+	}
+	return 0;
+}
+
+#endif // DOM_TRACE_DECODER